@@ -48,7 +48,9 @@ enum picotm_error_code {
     /** Invalid floating-point environment. */
     PICOTM_INVALID_FENV,
     /** Out-of-Bounds memory access. */
-    PICOTM_OUT_OF_BOUNDS
+    PICOTM_OUT_OF_BOUNDS,
+    /** Modification of a resource in a read-only transaction. */
+    PICOTM_READ_ONLY
 };
 
 /**
@@ -95,10 +95,24 @@ struct picotm_error;
  *          // concurrent users; start recovery
  *      }
  * ~~~
+ *
+ * By default, an R/W lock occupies a single byte. It supports up to
+ * 14 concurrent readers and only transactions of the first 15 threads
+ * can wait for the lock to become available. All other transactions
+ * fail with a conflict. Configuring picotm with `--enable-wide-rwlock`
+ * widens all R/W locks to 32 bits, with up to 65534 concurrent readers
+ * and waiters from all threads. Frames of the Transactional Memory
+ * module, the states of the txlib data structures and the fields of
+ * file descriptors all use `struct picotm_rwlock`, so they all benefit
+ * from the wider lock.
  */
 struct picotm_rwlock {
     /** counter variable */
+#if defined(PICOTM_HAVE_WIDE_RWLOCK) && PICOTM_HAVE_WIDE_RWLOCK
+    atomic_uint_least32_t n;
+#else
     atomic_uint_least8_t  n;
+#endif
 };
 
 /**
@@ -148,7 +162,8 @@ PICOTM_NOTHROW
  * \ingroup group_lib
  * Tries to acquire a writer lock or upgrade an acquired reader lock to
  * a writer lock. If the lock could not be acquired, the error parameter
- * will return a conflict.
+ * will return a conflict. In a read-only transaction, the error parameter
+ * returns the error code ::PICOTM_READ_ONLY.
  *
  * \param       self    The writer lock to acquire.
  * \param       upgrade True to upgrade a previously acquired reader lock.
@@ -149,6 +149,20 @@ typedef uintptr_t (*picotm_shared_treemap_value_create_function)(
 typedef void (*picotm_shared_treemap_value_destroy_function)(
     uintptr_t value, struct picotm_shared_treemap* treemap);
 
+/**
+ * \ingroup group_lib
+ * Invoked by picotm's shared treemap to call a value.
+ * \param       value   The value.
+ * \param       key     The value's key.
+ * \param       treemap The value's shared treemap.
+ * \param       data    User data.
+ * \param[out]  error   Returns an error from the call-back function.
+ */
+typedef void (*picotm_shared_treemap_value_call_function)(
+    uintptr_t value, unsigned long long key,
+    struct picotm_shared_treemap* treemap, void* data,
+    struct picotm_error* error);
+
 PICOTM_NOTHROW
 /**
  * \ingroup group_lib
@@ -192,4 +206,36 @@ picotm_shared_treemap_find_value(
     picotm_shared_treemap_value_destroy_function value_destroy,
     struct picotm_error* error);
 
+PICOTM_NOTHROW
+/**
+ * \ingroup group_lib
+ * Removes a value from a shared treemap. The value is only removed if
+ * it's still stored for the key. Concurrent look-ups might have already
+ * retrieved the value, so the caller has to defer destroying it until
+ * all of them have finished.
+ * \param   self    The shared treemap.
+ * \param   key     The value's key.
+ * \param   value   The value to remove.
+ * \returns True if the value has been removed, or false otherwise.
+ */
+_Bool
+picotm_shared_treemap_remove_value(struct picotm_shared_treemap* self,
+                                   unsigned long long key, uintptr_t value);
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_lib
+ * Iterates over all values stored in a shared treemap. Values that are
+ * inserted or removed concurrently might be missed.
+ * \param       self        The shared treemap.
+ * \param       data        User data.
+ * \param       value_call  The call-back function for values.
+ * \param[out]  error       Returns an error from the call-back function.
+ */
+void
+picotm_shared_treemap_for_each_value(
+    struct picotm_shared_treemap* self, void* data,
+    picotm_shared_treemap_value_call_function value_call,
+    struct picotm_error* error);
+
 PICOTM_END_DECLS
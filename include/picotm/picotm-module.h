@@ -48,6 +48,21 @@ PICOTM_BEGIN_DECLS
 
 struct picotm_tx;
 
+/**
+ * Represents an event in a transaction's event log.
+ */
+struct picotm_event {
+    /** The module number. */
+    uint16_t module;
+    /** The event's head data. */
+    uint16_t head;
+
+    /* Possibly padding bytes here */
+
+    /** The event's tail data, or a pointer to tail data. */
+    uintptr_t tail;
+};
+
 /**
  * Invoked by picotm at the beginning of a transaction.
  * \param       data    The pointer to module-specific data.
@@ -111,6 +126,81 @@ typedef void (*picotm_module_undo_event_function)(
     void* data,
     struct picotm_error* error);
 
+/**
+ * Invoked by picotm during the commit phase to apply a sequence of
+ * consecutive events of a module.
+ * \param       event   The first event.
+ * \param       nevents The number of events.
+ * \param       data    The pointer to module-specific data.
+ * \param[out]  error   Returns an error from the module.
+ *
+ * The events are given in the order of the transaction's event log. A
+ * module's consecutive events can be handed over in multiple sequences.
+ */
+typedef void (*picotm_module_apply_events_function)(
+    const struct picotm_event* event,
+    size_t nevents,
+    void* data,
+    struct picotm_error* error);
+
+/**
+ * Invoked by picotm during the roll-back phase to revert a sequence of
+ * consecutive events of a module.
+ * \param       event   The first event.
+ * \param       nevents The number of events.
+ * \param       data    The pointer to module-specific data.
+ * \param[out]  error   Returns an error from the module.
+ *
+ * The events are given in the order of the transaction's event log. The
+ * module shall revert them from the last to the first event. A module's
+ * consecutive events can be handed over in multiple sequences.
+ */
+typedef void (*picotm_module_undo_events_function)(
+    const struct picotm_event* event,
+    size_t nevents,
+    void* data,
+    struct picotm_error* error);
+
+/**
+ * Invoked by picotm at the beginning of a nested transaction.
+ * \param       data    The pointer to module-specific data.
+ * \param[out]  error   Returns an error from the module.
+ * \returns A module-specific mark of the module's current state.
+ */
+typedef uintptr_t (*picotm_module_savepoint_function)(
+    void* data,
+    struct picotm_error* error);
+
+/**
+ * Invoked by picotm to revert a module's changes since the beginning of
+ * a nested transaction.
+ * \param       mark    The module's mark at the beginning of the nested
+ *                      transaction.
+ * \param       data    The pointer to module-specific data.
+ * \param[out]  error   Returns an error from the module.
+ *
+ * Picotm reverts the events of the nested transaction afterwards. If
+ * the module cannot revert its changes, it returns a conflict and
+ * picotm restarts the outermost transaction.
+ */
+typedef void (*picotm_module_rollback_to_savepoint_function)(
+    uintptr_t mark,
+    void* data,
+    struct picotm_error* error);
+
+/**
+ * Invoked by picotm when a nested transaction commits. The module's
+ * changes since the savepoint become part of the parent transaction.
+ * \param       mark    The module's mark at the beginning of the nested
+ *                      transaction.
+ * \param       data    The pointer to module-specific data.
+ * \param[out]  error   Returns an error from the module.
+ */
+typedef void (*picotm_module_release_savepoint_function)(
+    uintptr_t mark,
+    void* data,
+    struct picotm_error* error);
+
 /**
  * Invoked by picotm to clean up a module's resources at the end of a
  * transaction.
@@ -139,6 +229,22 @@ struct picotm_module_ops {
     picotm_module_undo_event_function undo_event;
     picotm_module_finish_function finish;
     picotm_module_release_function release;
+
+    /* Optional call-backs for handling events in batches. If set,
+     * these functions are used instead of apply_event and undo_event. */
+
+    picotm_module_apply_events_function apply_events;
+    picotm_module_undo_events_function undo_events;
+
+    /* Optional call-backs for nested transactions. Picotm retries
+     * a conflicting nested transaction without restarting the outer
+     * transaction only if all of the touched modules that revert
+     * changes provide these functions. A module that keeps state
+     * for each savepoint releases it in release_savepoint. */
+
+    picotm_module_savepoint_function savepoint;
+    picotm_module_rollback_to_savepoint_function rollback_to_savepoint;
+    picotm_module_release_savepoint_function release_savepoint;
 };
 
 PICOTM_NOTHROW
@@ -153,6 +259,81 @@ unsigned long
 picotm_register_module(const struct picotm_module_ops* ops, void* data,
                        struct picotm_error* error);
 
+PICOTM_NOTHROW
+/**
+ * Marks a module as used by the current transaction. Only touched
+ * modules take part in the transaction's commit or roll-back. A module
+ * has to touch itself before it acquires resources that it releases
+ * in one of its call-back functions. Appending an event touches the
+ * module automatically. Modules with a begin call-back are touched
+ * at the beginning of each transaction.
+ * \param   module  The module number
+ */
+void
+picotm_touch_module(unsigned long module);
+
+/**
+ * \internal
+ * The number of the thread's current transaction. The number changes
+ * each time a transaction begins or restarts.
+ * \warning This is an internal interface. Don't use it in module code.
+ */
+extern __thread unsigned long __picotm_tx_number;
+
+/**
+ * Caches a module's thread-local state for the current transaction.
+ *
+ * Looking up the thread-local state and touching the module on each
+ * call into a module is expensive. A module can store its state in a
+ * thread-local cache after it looked up the state and touched itself.
+ * The cached state is only valid during the same run of the transaction.
+ * After the transaction restarts or a new transaction begins, the cache
+ * returns `nullptr` and the module has to look up its state again.
+ */
+struct picotm_module_cache {
+    /** \internal The number of the transaction that filled the cache. */
+    unsigned long tx_number;
+    /** \internal The cached module state. */
+    void* data;
+};
+
+/**
+ * Initializer macro for module caches.
+ */
+#define PICOTM_MODULE_CACHE_INITIALIZER \
+{                                       \
+    .tx_number = 0,                     \
+    .data = nullptr                     \
+}
+
+/**
+ * Returns the cached module state.
+ * \param   self    The module cache.
+ * \returns The cached module state if the cache was filled by the current
+ *          transaction, or `nullptr` otherwise.
+ */
+static inline void*
+picotm_module_cache_get(const struct picotm_module_cache* self)
+{
+    if (self->tx_number != __picotm_tx_number) {
+        return nullptr;
+    }
+    return self->data;
+}
+
+/**
+ * Fills a module cache for the current transaction. The module has to
+ * touch itself before.
+ * \param   self    The module cache.
+ * \param   data    The module state.
+ */
+static inline void
+picotm_module_cache_set(struct picotm_module_cache* self, void* data)
+{
+    self->tx_number = __picotm_tx_number;
+    self->data = data;
+}
+
 PICOTM_NOTHROW
 /**
  * Appends an event to the transaction's event log.
@@ -165,6 +346,24 @@ void
 picotm_append_event(unsigned long module, uint16_t head, uintptr_t tail,
                     struct picotm_error* error);
 
+PICOTM_NOTHROW
+/**
+ * Appends multiple events of the same module to the transaction's event
+ * log. This is equivalent to calling picotm_append_event() for each
+ * event, but only acquires the transaction's state once.
+ * \param       module  The module number
+ * \param       nevents The number of events.
+ * \param       head    An array of nevents module-specific head values.
+ * \param       tail    An array of nevents module-specific tail values,
+ *                      or pointers to tail data.
+ * \param[out]  error   Returns an error. On errors, no event has been
+ *                      appended to the log.
+ */
+void
+picotm_append_events(unsigned long module, size_t nevents,
+                     const uint16_t head[], const uintptr_t tail[],
+                     struct picotm_error* error);
+
 PICOTM_NOTHROW
 /**
  * Instructs the transaction management system to resolve a conflict between
@@ -266,6 +465,46 @@ PICOTM_NOTHROW
 bool
 picotm_is_irrevocable(void);
 
+struct picotm_rwlock;
+
+/**
+ * Describes a lock for the conflict profiler.
+ * \param      lock    The lock.
+ * \param      data    The data argument of the lock range.
+ * \param[out] buf     Returns the lock's description.
+ * \param      siz     The size of the buffer.
+ */
+typedef void (*picotm_describe_lock_function)(
+    const struct picotm_rwlock* lock, const void* data, char* buf,
+    size_t siz);
+
+PICOTM_NOTHROW
+/**
+ * Registers a range of locks with the conflict profiler. The profiler
+ * invokes the describe function for locks in the range when it records
+ * their first conflict. Nothing happens if profiling is disabled. Locks
+ * of ranges that have been registered before profiling was enabled are
+ * reported without description.
+ * \param  beg         The beginning of the range.
+ * \param  end         The end of the range.
+ * \param  describe    The describe function.
+ * \param  data        The data argument for the describe function.
+ */
+void
+picotm_register_lock_range(const void* beg, const void* end,
+                           picotm_describe_lock_function describe,
+                           const void* data);
+
+PICOTM_NOTHROW
+/**
+ * Unregisters a range of locks from the conflict profiler. Call this
+ * function for each registered range, even after profiling has been
+ * disabled.
+ * \param  beg The beginning of the range.
+ */
+void
+picotm_unregister_lock_range(const void* beg);
+
 PICOTM_END_DECLS
 
 /**
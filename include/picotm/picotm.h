@@ -24,6 +24,8 @@
 #include <mach/mach.h>
 #endif
 #include <setjmp.h>
+#include <stddef.h>
+#include <stdio.h>
 #if defined(PICOTM_HAVE_SIGNAL_H) && PICOTM_HAVE_SIGNAL_H
 #include <signal.h>
 #endif
@@ -89,7 +91,8 @@ enum __picotm_mode {
     PICOTM_MODE_RETRY,
     PICOTM_MODE_IRREVOCABLE,
     PICOTM_MODE_RECOVERY,
-    PICOTM_MODE_RESTART
+    PICOTM_MODE_RESTART,
+    PICOTM_MODE_RETRY_NESTED
 };
 
 #if defined(PICOTM_HAVE_TYPE_SIGJMP_BUF) && PICOTM_HAVE_TYPE_SIGJMP_BUF ||  \
@@ -104,16 +107,17 @@ enum __picotm_mode {
 /**
  * \ingroup group_core
  * \internal
- * Sets a non-local goto target. For systems with Unix signals, the
- * macro saves the signal mask.
+ * Sets a non-local goto target. The macro doesn't save the signal
+ * mask. Saving the signal mask requires a system call on each
+ * transaction's start. Modules that restart a transaction from a
+ * signal handler restore the signal mask by themselves.
  * \warning This is an internal interface. Don't use it in application code.
  */
-#define __picotm_setjmp(env_)   ((enum __picotm_mode)sigsetjmp(env_, 1))
+#define __picotm_setjmp(env_)   ((enum __picotm_mode)sigsetjmp(env_, 0))
 /**
  * \ingroup group_core
  * \internal
- * Performs a non-local goto. For systems with Unix signals, the macro
- * restores the signal mask.
+ * Performs a non-local goto.
  * \warning This is an internal interface. Don't use it in application code.
  */
 #define __picotm_longjmp(env_, val_)    siglongjmp(env_, val_)
@@ -141,6 +145,33 @@ __picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env);
  * this macro and ::picotm_commit is considered part of the transaction's
  * execution phase. If the transaction aborts, it will restart from where
  * the ::picotm_begin had been invoked.
+ *
+ * Invoking ::picotm_begin within a running transaction starts a nested
+ * transaction. Committing the nested transaction makes it part of the
+ * enclosing transaction. On conflicts, picotm rolls back only the nested
+ * transaction and retries it from its ::picotm_begin. The enclosing
+ * transaction keeps its locks meanwhile. Conflicts that persist, errors,
+ * and switching to irrevocable mode still restart the outermost
+ * transaction, which also runs the recovery code.
+ *
+ * ~~~{.c}
+ *  picotm_begin
+ *
+ *      [...]
+ *
+ *      picotm_begin
+ *
+ *          // retried separately on conflicts
+ *
+ *      picotm_commit
+ *      picotm_end
+ *
+ *  picotm_commit
+ *
+ *      [...]
+ *
+ *  picotm_end
+ * ~~~
  */
 #define picotm_begin                                            \
     {                                                           \
@@ -148,6 +179,45 @@ __picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env);
         if (__picotm_begin(__picotm_setjmp(__env), &__env))     \
         {
 
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * \internal
+ * Begins or restarts a read-only transaction, or handles an error.
+ * \warning This is an internal interface. Don't use it in application code.
+ */
+_Bool
+__picotm_begin_readonly(enum __picotm_mode mode, __picotm_jmp_buf* env);
+
+/**
+ * \ingroup group_core
+ * Starts a new read-only transaction.
+ *
+ * Invoking ::picotm_begin_readonly starts a new transaction that
+ * promises not to modify any resources. Operations that would modify
+ * a resource fail with the error code ::PICOTM_READ_ONLY. In return,
+ * committing a read-only transaction only releases its locks. Finish
+ * the transaction with ::picotm_commit and ::picotm_end, as with
+ * ::picotm_begin.
+ *
+ * ~~~{.c}
+ *  picotm_begin_readonly
+ *
+ *      value = load_int_tx(&shared_value);
+ *
+ *  picotm_commit
+ *
+ *      [...]
+ *
+ *  picotm_end
+ * ~~~
+ */
+#define picotm_begin_readonly                                           \
+    {                                                                   \
+        __picotm_jmp_buf __env;                                         \
+        if (__picotm_begin_readonly(__picotm_setjmp(__env), &__env))    \
+        {
+
 PICOTM_NOTHROW
 /**
  * \ingroup group_core
@@ -198,6 +268,225 @@ PICOTM_NOTHROW
 unsigned long
 picotm_number_of_restarts(void);
 
+/**
+ * \ingroup group_core
+ * \brief Policies for resolving conflicts among transactions.
+ *
+ * A contention-management policy decides if a transaction waits for
+ * a lock held by another transaction or aborts immediately, and which
+ * of the waiting transactions is woken up first when a lock becomes
+ * available.
+ *
+ * The policy is process-wide. It's set by picotm_set_contention_policy()
+ * or by the environment variable `PICOTM_CONTENTION_POLICY`, which
+ * contains the policy's name in lower-case letters; for example
+ * `PICOTM_CONTENTION_POLICY=karma`. If both are present, the function
+ * call takes precedence.
+ */
+enum picotm_contention_policy {
+    /**
+     * Older transactions take precedence. A transaction waits for
+     * locks after it has been running for a while, including all of
+     * its restarts. The oldest waiting transaction is woken up first.
+     * This is the default policy.
+     */
+    PICOTM_CONTENTION_POLICY_GREEDY,
+    /**
+     * Transactions that did more work take precedence. A transaction's
+     * karma is the number of events it logged, including the events
+     * of all of its restarts. Only transactions with sufficient karma
+     * wait for locks. The waiting transaction with the highest karma
+     * is woken up first.
+     */
+    PICOTM_CONTENTION_POLICY_KARMA,
+    /**
+     * Like ::PICOTM_CONTENTION_POLICY_KARMA, but every transaction
+     * waits for locks. The maximum waiting time grows exponentially
+     * with the number of restarts.
+     */
+    PICOTM_CONTENTION_POLICY_POLKA,
+    /**
+     * A transaction never waits for a lock and aborts on conflicts
+     * immediately.
+     */
+    PICOTM_CONTENTION_POLICY_PASSIVE,
+    /**
+     * A transaction always waits for locks. The longest waiting
+     * transaction is woken up first.
+     */
+    PICOTM_CONTENTION_POLICY_AGGRESSIVE
+};
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Sets the process-wide contention-management policy.
+ *
+ * Values that are not a policy of ::picotm_contention_policy
+ * are ignored and the current policy remains in effect.
+ *
+ * \param policy The new contention-management policy.
+ */
+void
+picotm_set_contention_policy(enum picotm_contention_policy policy);
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Returns the process-wide contention-management policy.
+ *
+ * \returns The current contention-management policy.
+ */
+enum picotm_contention_policy
+picotm_get_contention_policy(void);
+
+/**
+ * \ingroup group_core
+ * \brief Transaction statistics.
+ *
+ * Each thread maintains its own counters. The counters are
+ * aggregated over all threads, including terminated ones, when
+ * the statistics are read with picotm_get_stats().
+ */
+struct picotm_stats {
+    /** The number of committed transactions. */
+    unsigned long long ncommits;
+
+    /** The number of retries of all committed transactions. */
+    unsigned long long nretries;
+
+    /** The largest number of retries of a single committed transaction. */
+    unsigned long long max_nretries;
+
+    /** The number of aborts from conflicts among transactions. */
+    unsigned long long naborts_conflicting;
+
+    /** The number of aborts to switch to irrevocable mode. */
+    unsigned long long naborts_revocable;
+
+    /** The number of aborts from errors with an error code. */
+    unsigned long long naborts_error_code;
+
+    /** The number of aborts from errors with an errno code. */
+    unsigned long long naborts_errno;
+
+    /** The number of aborts from errors with a kern_return_t value. */
+    unsigned long long naborts_kern_return_t;
+
+    /** The number of aborts from signals. */
+    unsigned long long naborts_siginfo_t;
+
+    /** The number of aborts from calls to picotm_restart(). */
+    unsigned long long naborts_restart;
+
+    /** The number of transactions that escalated to irrevocable mode. */
+    unsigned long long nirrevocable;
+
+    /** The time spent waiting for locks in nanoseconds. */
+    unsigned long long wait_ns;
+
+    /** The time spent in irrevocable mode in nanoseconds. */
+    unsigned long long irrevocable_ns;
+};
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Returns the process-wide transaction statistics.
+ *
+ * Reading the statistics briefly locks the list of threads. Threads
+ * don't synchronize when they update their counters, so the returned
+ * values form no consistent snapshot while transactions are running.
+ *
+ * \param[out] stats Returns the transaction statistics.
+ */
+void
+picotm_get_stats(struct picotm_stats* stats);
+
+struct picotm_rwlock;
+
+/**
+ * \ingroup group_core
+ * The size of a conflict hotspot's description.
+ */
+#define PICOTM_CONFLICT_HOTSPOT_DESCRIPTION_SIZE   (96)
+
+/**
+ * \ingroup group_core
+ * \brief A lock with conflicts among transactions.
+ *
+ * The conflict profiler counts the conflicts on each lock. Modules
+ * describe their locks, such as the memory range of a frame or the
+ * field of an open file description.
+ */
+struct picotm_conflict_hotspot {
+    /** The lock's address. */
+    const struct picotm_rwlock* lock;
+
+    /** The number of conflicts on the lock. */
+    unsigned long nconflicts;
+
+    /** A description of the lock's owner. */
+    char description[PICOTM_CONFLICT_HOTSPOT_DESCRIPTION_SIZE];
+};
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Enables or disables conflict profiling.
+ *
+ * Conflict profiling is disabled by default. Setting the environment
+ * variable `PICOTM_CONFLICT_PROFILE` to a number N enables profiling
+ * at startup and prints the top-N hotspots to `stderr` at exit. Only
+ * locks of objects created while profiling is enabled receive a
+ * description.
+ *
+ * \param enabled True to enable profiling, or false to disable it.
+ */
+void
+picotm_set_conflict_profiling(_Bool enabled);
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Returns the locks with the most conflicts.
+ *
+ * \param[out] hotspot Returns the hotspots, sorted by decreasing
+ *                     number of conflicts.
+ * \param      n       The maximum number of hotspots to return.
+ * \returns The number of returned hotspots.
+ */
+size_t
+picotm_get_conflict_hotspots(struct picotm_conflict_hotspot* hotspot,
+                             size_t n);
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Prints a report of the locks with the most conflicts.
+ *
+ * \param stream The output stream.
+ * \param n      The maximum number of reported locks.
+ */
+void
+picotm_print_conflict_hotspots(FILE* stream, size_t n);
+
+PICOTM_NOTHROW
+/**
+ * \ingroup group_core
+ * Writes the recorded trace events of all threads to the trace file.
+ *
+ * Tracing is only available if picotm has been configured with
+ * `--enable-tracing`. It records events if the environment variable
+ * `PICOTM_TRACE_FILE` contains the name of the trace file. The trace
+ * is written automatically at exit. Each call appends the events that
+ * have been recorded since the previous call. The script
+ * `tools/picotm-trace2json.pl` converts the trace file to the Chrome
+ * trace format.
+ */
+void
+picotm_flush_trace(void);
+
 PICOTM_NOTHROW
 void
 /**
@@ -56,5 +56,23 @@ AC_DEFUN([CONFIG_TM], [
                    [test "x$enable_module_tm" = "xyes"])
     AS_VAR_IF([enable_module_tm], [yes], [
         _CONFIG_TM
+
+        #
+        # TM compile-time constants
+        #
+
+        AC_ARG_WITH([tm-block-size],
+                    [AS_HELP_STRING([--with-tm-block-size=SIZE],
+                                    [size of Transactional Memory blocks in bytes; one of 8, 16, 32 or 64 @<:@default=8@:>@])],
+                    [tm_block_size=$withval],
+                    [tm_block_size=8])
+        AS_CASE([$tm_block_size],
+                [8],  [tm_block_size_bits=3],
+                [16], [tm_block_size_bits=4],
+                [32], [tm_block_size_bits=5],
+                [64], [tm_block_size_bits=6],
+                [AC_MSG_ERROR([invalid TM block size $tm_block_size])])
+        AC_DEFINE_UNQUOTED([TM_BLOCK_SIZE_BITS], [$tm_block_size_bits],
+                           [Bits per TM block])
     ])
 ])
@@ -161,11 +161,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(allocator_module)
 static struct allocator_tx*
 get_allocator_tx(struct picotm_error* error)
 {
-    struct allocator_module* module =
-        PICOTM_THREAD_STATE_ACQUIRE(allocator_module, true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct allocator_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(allocator_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->log.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
@@ -124,11 +124,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(error_module)
 static struct error_tx*
 get_error_tx(struct picotm_error* error)
 {
-    struct error_module* module = PICOTM_THREAD_STATE_ACQUIRE(error_module,
-                                                              true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct error_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(error_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->tx.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
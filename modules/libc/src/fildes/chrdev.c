@@ -21,6 +21,8 @@
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
 #include "picotm/picotm-lib-rwstate.h"
+#include "picotm/picotm-module.h"
+#include <stdio.h>
 
 static void
 init_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
@@ -40,6 +42,21 @@ uninit_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
     }
 }
 
+static void
+describe_rwlock(const struct picotm_rwlock* lock, const void* data,
+                char* buf, size_t siz)
+{
+    static const char* const field_name[] = {
+        [CHRDEV_FIELD_FILE_MODE] = "CHRDEV_FIELD_FILE_MODE",
+        [CHRDEV_FIELD_STATE] = "CHRDEV_FIELD_STATE"
+    };
+
+    const struct chrdev* chrdev = data;
+
+    snprintf(buf, siz, "chrdev %p: %s", data,
+             field_name[lock - chrdev->rwlock]);
+}
+
 void
 chrdev_init(struct chrdev* self, struct picotm_error* error)
 {
@@ -52,6 +69,10 @@ chrdev_init(struct chrdev* self, struct picotm_error* error)
 
     init_rwlocks(picotm_arraybeg(self->rwlock),
                  picotm_arrayend(self->rwlock));
+
+    picotm_register_lock_range(picotm_arraybeg(self->rwlock),
+                               picotm_arrayend(self->rwlock),
+                               describe_rwlock, self);
 }
 
 void
@@ -59,6 +80,8 @@ chrdev_uninit(struct chrdev* self)
 {
     assert(self);
 
+    picotm_unregister_lock_range(picotm_arraybeg(self->rwlock));
+
     uninit_rwlocks(picotm_arraybeg(self->rwlock),
                    picotm_arrayend(self->rwlock));
 
@@ -22,9 +22,11 @@
 #include "picotm/picotm-lib-array.h"
 #include "picotm/picotm-lib-ptr.h"
 #include "picotm/picotm-lib-rwstate.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "compat/temp_failure_retry.h"
@@ -53,6 +55,20 @@ uninit_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
     }
 }
 
+static void
+describe_rwlock(const struct picotm_rwlock* lock, const void* data,
+                char* buf, size_t siz)
+{
+    static const char* const field_name[] = {
+        [FD_FIELD_STATE] = "FD_FIELD_STATE"
+    };
+
+    const struct fd* fd = data;
+
+    snprintf(buf, siz, "fd %d: %s", fd->fildes,
+             field_name[lock - fd->rwlock]);
+}
+
 void
 fd_init(struct fd* self, struct picotm_error* error)
 {
@@ -68,6 +84,10 @@ fd_init(struct fd* self, struct picotm_error* error)
 
     init_rwlocks(picotm_arraybeg(self->rwlock),
                  picotm_arrayend(self->rwlock));
+
+    picotm_register_lock_range(picotm_arraybeg(self->rwlock),
+                               picotm_arrayend(self->rwlock),
+                               describe_rwlock, self);
 }
 
 void
@@ -75,6 +95,8 @@ fd_uninit(struct fd* self)
 {
     assert(self);
 
+    picotm_unregister_lock_range(picotm_arraybeg(self->rwlock));
+
     uninit_rwlocks(picotm_arraybeg(self->rwlock),
                    picotm_arrayend(self->rwlock));
 
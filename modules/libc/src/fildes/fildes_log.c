@@ -88,8 +88,10 @@ fildes_log_append(struct fildes_log* self, enum fildes_op op, int fildes,
     event->fildes = fildes;
     event->cookie = cookie;
 
-    picotm_append_event(self->module, op, (uintptr_t)(event - self->eventtab),
-                        error);
+    const uint16_t head = op;
+    const uintptr_t tail = event - self->eventtab;
+
+    picotm_append_events(self->module, 1, &head, &tail, error);
     if (picotm_error_is_set(error)) {
         return;
     }
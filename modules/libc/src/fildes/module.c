@@ -219,11 +219,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(fildes_module)
 static struct fildes_tx*
 get_fildes_tx(struct picotm_error* error)
 {
-    struct fildes_module* module = PICOTM_THREAD_STATE_ACQUIRE(fildes_module,
-                                                               true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct fildes_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(fildes_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->log.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
@@ -21,6 +21,8 @@
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
 #include "picotm/picotm-lib-rwstate.h"
+#include "picotm/picotm-module.h"
+#include <stdio.h>
 
 static void
 init_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
@@ -40,6 +42,22 @@ uninit_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
     }
 }
 
+static void
+describe_rwlock(const struct picotm_rwlock* lock, const void* data,
+                char* buf, size_t siz)
+{
+    static const char* const field_name[] = {
+        [REGFILE_FIELD_FILE_MODE] = "REGFILE_FIELD_FILE_MODE",
+        [REGFILE_FIELD_STATE] = "REGFILE_FIELD_STATE",
+        [REGFILE_FIELD_FILE_OFFSET] = "REGFILE_FIELD_FILE_OFFSET"
+    };
+
+    const struct regfile* regfile = data;
+
+    snprintf(buf, siz, "regfile %p: %s", data,
+             field_name[lock - regfile->rwlock]);
+}
+
 void
 regfile_init(struct regfile* self, struct picotm_error* error)
 {
@@ -52,11 +70,17 @@ regfile_init(struct regfile* self, struct picotm_error* error)
 
     init_rwlocks(picotm_arraybeg(self->rwlock),
                  picotm_arrayend(self->rwlock));
+
+    picotm_register_lock_range(picotm_arraybeg(self->rwlock),
+                               picotm_arrayend(self->rwlock),
+                               describe_rwlock, self);
 }
 
 void
 regfile_uninit(struct regfile* self)
 {
+    picotm_unregister_lock_range(picotm_arraybeg(self->rwlock));
+
     uninit_rwlocks(picotm_arraybeg(self->rwlock),
                    picotm_arrayend(self->rwlock));
 
@@ -21,6 +21,8 @@
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
 #include "picotm/picotm-lib-rwstate.h"
+#include "picotm/picotm-module.h"
+#include <stdio.h>
 
 static void
 init_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
@@ -40,6 +42,21 @@ uninit_rwlocks(struct picotm_rwlock* beg, const struct picotm_rwlock* end)
     }
 }
 
+static void
+describe_rwlock(const struct picotm_rwlock* lock, const void* data,
+                char* buf, size_t siz)
+{
+    static const char* const field_name[] = {
+        [SOCKET_FIELD_FILE_MODE] = "SOCKET_FIELD_FILE_MODE",
+        [SOCKET_FIELD_STATE] = "SOCKET_FIELD_STATE"
+    };
+
+    const struct socket* socket = data;
+
+    snprintf(buf, siz, "socket %p: %s", data,
+             field_name[lock - socket->rwlock]);
+}
+
 void
 socket_init(struct socket* self, struct picotm_error* error)
 {
@@ -52,11 +69,17 @@ socket_init(struct socket* self, struct picotm_error* error)
 
     init_rwlocks(picotm_arraybeg(self->rwlock),
                  picotm_arrayend(self->rwlock));
+
+    picotm_register_lock_range(picotm_arraybeg(self->rwlock),
+                               picotm_arrayend(self->rwlock),
+                               describe_rwlock, self);
 }
 
 void
 socket_uninit(struct socket* self)
 {
+    picotm_unregister_lock_range(picotm_arraybeg(self->rwlock));
+
     uninit_rwlocks(picotm_arraybeg(self->rwlock),
                    picotm_arrayend(self->rwlock));
 
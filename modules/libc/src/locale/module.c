@@ -197,11 +197,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(locale_module)
 static struct locale_tx*
 get_locale_tx(struct picotm_error* error)
 {
-    struct locale_module* module = PICOTM_THREAD_STATE_ACQUIRE(locale_module,
-                                                               true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct locale_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(locale_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->log.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
@@ -149,7 +149,7 @@ tx_signal_handler(int signum, siginfo_t* info, void* ucontext)
         return;
     }
 
-    signal_tx_recover_from_signal(tx, info);
+    signal_tx_recover_from_signal(tx, info, ucontext);
 }
 
 void
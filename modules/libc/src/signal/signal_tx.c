@@ -23,6 +23,7 @@
 #include "picotm/picotm-lib-tab.h"
 #include "picotm/picotm-module.h"
 #include <errno.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdint.h>
 #include <string.h>
@@ -89,7 +90,8 @@ signal_tx_clear_signals(struct signal_tx* self)
 }
 
 void
-signal_tx_recover_from_signal(struct signal_tx* self, const siginfo_t* info)
+signal_tx_recover_from_signal(struct signal_tx* self, const siginfo_t* info,
+                              const void* ucontext)
 {
     if (!self->tx_is_running) {
         return;
@@ -106,6 +108,14 @@ signal_tx_recover_from_signal(struct signal_tx* self, const siginfo_t* info)
     if (self->signal_state[info->si_signo] == 2) {
         picotm_error_mark_as_non_recoverable(&error);
     }
+
+    /* The signal is blocked while its handler runs. We leave the
+     * handler by restarting the transaction, so we have to unblock
+     * the signal here. Transactions don't save the signal mask when
+     * they begin. */
+    const ucontext_t* context = ucontext;
+    pthread_sigmask(SIG_SETMASK, &context->uc_sigmask, nullptr);
+
     picotm_recover_from_error(&error);
 }
 
@@ -93,8 +93,19 @@ signal_tx_remove_signal(struct signal_tx* self, int signum);
 void
 signal_tx_clear_signals(struct signal_tx* self);
 
+/**
+ * Recovers the transaction from a signal.
+ * \param   self        The signal-handler transaction.
+ * \param   info        The signal's information.
+ * \param   ucontext    The signal handler's context.
+ *
+ * Restarting the transaction doesn't restore the thread's signal mask.
+ * The function restores the signal mask from the signal handler's
+ * context before it recovers.
+ */
 void
-signal_tx_recover_from_signal(struct signal_tx* self, const siginfo_t* info);
+signal_tx_recover_from_signal(struct signal_tx* self, const siginfo_t* info,
+                              const void* ucontext);
 
 /**
  * Sets up a new transaction's signal handling.
@@ -128,11 +128,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(fpu_module)
 static struct fpu_tx*
 get_fpu_tx(struct picotm_error* error)
 {
-    struct fpu_module* module = PICOTM_THREAD_STATE_ACQUIRE(fpu_module,
-                                                            true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct fpu_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(fpu_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->tx.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
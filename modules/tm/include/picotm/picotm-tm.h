@@ -264,6 +264,17 @@ privatize_c_tx(const void* addr, int c, unsigned long flags)
         privatize_tx(addr, sizeof(*addr), flags);                           \
     }
 
+PICOTM_NOTHROW
+/**
+ * \ingroup group_tm
+ * Returns the number of bytes that Transactional Memory currently
+ * allocates for the state of accessed memory. The memory of regions
+ * that haven't been accessed for a while gets released.
+ * \returns The allocated memory in bytes.
+ */
+size_t
+picotm_tm_get_memory_usage(void);
+
 PICOTM_END_DECLS
 
 /**
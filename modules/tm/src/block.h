@@ -29,17 +29,43 @@
  * \endcond
  */
 
-/* TODO: The block size should be independent from the properties of
- * malloc. This requires a clean-up in the page-handling algorithm.
+/*
+ * The block size is a power of 2 from 8 to 64 bytes. It's selected
+ * with the configure option --with-tm-block-size. Larger blocks require
+ * less frames, locks and pages for large accesses, but cause false
+ * conflicts between transactions that access neighboring data.
  *
- * Power of 2; possibly length of cache lines, but no larger than
- * aligment and minimal size of malloc'ed memory. Otherwise we might
- * corrupt malloc's internal data structures.
+ * Committing a transaction writes back all of a block's bytes that
+ * the transaction read or wrote. Non-transactional code must not
+ * modify memory within the same block concurrently, so blocks should
+ * be no larger than the alignment and minimal size of malloc'ed memory.
+ * Otherwise we might corrupt malloc's internal data structures.
  */
+#if !defined(TM_BLOCK_SIZE_BITS)
 #define TM_BLOCK_SIZE_BITS      (3)
+#endif
 #define TM_BLOCK_SIZE           (1ul << TM_BLOCK_SIZE_BITS)
-#define TM_BLOCK_OFFSET_MASK    ((1ul << TM_BLOCK_SIZE) - 1)
-#define TM_BLOCK_INDEX_MASK     (~TM_BLOCK_FIELD_MASK)
+#define TM_BLOCK_OFFSET_MASK    (TM_BLOCK_SIZE - 1)
+
+#if (TM_BLOCK_SIZE_BITS < 3) || (TM_BLOCK_SIZE_BITS > 6)
+#error TM block size must be from 8 to 64 bytes
+#endif
+
+/**
+ * A bitmap with one bit for each byte in a block.
+ */
+#if TM_BLOCK_SIZE_BITS == 3
+typedef uint8_t tm_block_bitmap;
+#elif TM_BLOCK_SIZE_BITS == 4
+typedef uint16_t tm_block_bitmap;
+#elif TM_BLOCK_SIZE_BITS == 5
+typedef uint32_t tm_block_bitmap;
+#else
+typedef uint64_t tm_block_bitmap;
+#endif
+
+/** A block bitmap with the bits of all bytes set. */
+#define TM_BLOCK_BITMAP_ALL     ((tm_block_bitmap)~(tm_block_bitmap)0)
 
 static inline size_t
 tm_block_index_at(uintptr_t addr)
@@ -20,9 +20,14 @@
 #include "framemap.h"
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
+#include "picotm/picotm-lib-ptr.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "block.h"
 #include "frame.h"
 
@@ -34,13 +39,39 @@
 #define TM_FRAME_TBL_SIZE       (1ul << TM_FRAME_TBL_SIZE_BITS)
 #define TM_FRAME_TBL_SIZE_MASK  (TM_FRAME_TBL_SIZE - 1)
 
+enum tm_frame_tbl_state {
+    /* The table is in use. */
+    TM_FRAME_TBL_LIVE,
+    /* The table is a candidate for reclamation. The next look-up
+     * of the table resets its state to TM_FRAME_TBL_LIVE. */
+    TM_FRAME_TBL_MARKED,
+    /* The table has been reclaimed. */
+    TM_FRAME_TBL_DEAD
+};
+
 struct tm_frame_tbl {
+    atomic_uint state;
+
+    /* fields for reclamation */
+    struct picotm_slist list;
+    unsigned long retire_epoch;
+
     struct tm_frame frame[TM_FRAME_TBL_SIZE];
 };
 
+static struct tm_frame_tbl*
+tm_frame_tbl_of_slist(struct picotm_slist* item)
+{
+    return picotm_containerof(item, struct tm_frame_tbl, list);
+}
+
 static void
 tm_frame_tbl_init(struct tm_frame_tbl* self, size_t first_block_index)
 {
+    atomic_init(&self->state, TM_FRAME_TBL_LIVE);
+    picotm_slist_init_item(&self->list);
+    self->retire_epoch = 0;
+
     struct tm_frame* beg = picotm_arraybeg(self->frame);
     const struct tm_frame* end = picotm_arrayend(self->frame);
 
@@ -58,6 +89,47 @@ tm_frame_tbl_uninit(struct tm_frame_tbl* self)
     while (beg < end) {
         tm_frame_uninit(beg++);
     }
+
+    picotm_slist_uninit_item(&self->list);
+}
+
+/* Returns true if the table can be used, or false if it has been
+ * reclaimed. */
+static bool
+tm_frame_tbl_try_use(struct tm_frame_tbl* self)
+{
+    unsigned int state = atomic_load_explicit(&self->state,
+                                              memory_order_relaxed);
+    if (state == TM_FRAME_TBL_LIVE) {
+        return true;
+    } else if (state == TM_FRAME_TBL_MARKED) {
+        /* Rescue the table from reclamation. This fails if the
+         * table has been reclaimed concurrently. */
+        atomic_compare_exchange_strong_explicit(&self->state, &state,
+                                                TM_FRAME_TBL_LIVE,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed);
+        return state != TM_FRAME_TBL_DEAD;
+    }
+    return false;
+}
+
+static void
+describe_frame_lock(const struct picotm_rwlock* lock, const void* data,
+                   char* buf, size_t siz)
+{
+    const struct tm_frame* frame = picotm_containerof(lock, struct tm_frame,
+                                                      rwlock);
+    uintptr_t addr = tm_frame_address(frame);
+
+    snprintf(buf, siz, "tm frame 0x%" PRIxPTR "-0x%" PRIxPTR,
+             addr, addr + TM_BLOCK_SIZE);
+}
+
+static struct tm_frame_map*
+frame_map_of_treemap(struct picotm_shared_treemap* treemap)
+{
+    return picotm_containerof(treemap, struct tm_frame_map, map);
 }
 
 static uintptr_t
@@ -73,6 +145,13 @@ tm_frame_tbl_create(unsigned long long key,
 
     tm_frame_tbl_init(tbl, key << TM_FRAME_TBL_SIZE_BITS);
 
+    picotm_register_lock_range(picotm_arraybeg(tbl->frame),
+                               picotm_arrayend(tbl->frame),
+                               describe_frame_lock, tbl);
+
+    atomic_fetch_add_explicit(&frame_map_of_treemap(treemap)->memory_usage,
+                              sizeof(*tbl), memory_order_relaxed);
+
     return (uintptr_t)tbl;
 }
 
@@ -81,6 +160,11 @@ tm_frame_tbl_destroy(uintptr_t value, struct picotm_shared_treemap* treemap)
 {
     struct tm_frame_tbl* tbl = (struct tm_frame_tbl*)value;
 
+    atomic_fetch_sub_explicit(&frame_map_of_treemap(treemap)->memory_usage,
+                              sizeof(*tbl), memory_order_relaxed);
+
+    picotm_unregister_lock_range(picotm_arraybeg(tbl->frame));
+
     tm_frame_tbl_uninit(tbl);
     free(tbl);
 }
@@ -101,11 +185,33 @@ tm_frame_map_init(struct tm_frame_map* self)
             (TM_FRAME_TBL_SIZE_BITS + TM_BLOCK_SIZE_BITS);
 
     picotm_shared_treemap_init(&self->map, key_nbits, 10);
+
+    atomic_init(&self->epoch, 1);
+    atomic_init(&self->memory_usage, 0);
+    atomic_init(&self->generation, 0);
+
+    picotm_spinlock_init(&self->lock);
+    picotm_slist_init_head(&self->readers);
+    picotm_slist_init_head(&self->retired_tbls);
+    self->mark_epoch = 0;
+    self->has_marked_tbls = false;
+}
+
+static void
+destroy_retired_tbl(struct picotm_slist* item, void* data)
+{
+    tm_frame_tbl_destroy((uintptr_t)tm_frame_tbl_of_slist(item), data);
 }
 
 void
 tm_frame_map_uninit(struct tm_frame_map* self)
 {
+    picotm_slist_cleanup_1(&self->retired_tbls, destroy_retired_tbl,
+                           &self->map);
+    picotm_slist_uninit_head(&self->retired_tbls);
+    picotm_slist_uninit_head(&self->readers);
+    picotm_spinlock_uninit(&self->lock);
+
     picotm_shared_treemap_uninit(&self->map, tm_frame_tbl_destroy);
 }
 
@@ -121,20 +227,268 @@ frame_tbl_index(uintptr_t addr)
     return (addr >> TM_BLOCK_SIZE_BITS) & TM_FRAME_TBL_SIZE_MASK;
 }
 
+static struct tm_frame_tbl*
+lookup_tbl(struct tm_frame_map* self, unsigned long long key,
+           struct picotm_error* error)
+{
+    do {
+        uintptr_t value = picotm_shared_treemap_find_value(
+            &self->map, key, tm_frame_tbl_create, tm_frame_tbl_destroy,
+            error);
+        if (picotm_error_is_set(error)) {
+            return nullptr;
+        }
+        struct tm_frame_tbl* tbl = (struct tm_frame_tbl*)value;
+
+        if (tm_frame_tbl_try_use(tbl)) {
+            return tbl;
+        }
+
+        /* The table has been reclaimed. Remove it from the map, so
+         * that the next look-up creates a new one. */
+        picotm_shared_treemap_remove_value(&self->map, key, value);
+    } while (true);
+}
+
 struct tm_frame*
-tm_frame_map_lookup(struct tm_frame_map* self, uintptr_t addr,
+tm_frame_map_lookup(struct tm_frame_map* self,
+                    struct tm_frame_map_reader* reader, uintptr_t addr,
                     struct picotm_error* error)
 {
     assert(self);
+    assert(reader);
+
+    unsigned long long key = frame_tbl_offset(addr);
+
+    struct tm_frame_map_cache_entry* entry =
+        reader->cache + (key & (TM_FRAME_MAP_CACHE_SIZE - 1));
 
-    uintptr_t value = picotm_shared_treemap_find_value(
-        &self->map, frame_tbl_offset(addr),
-        tm_frame_tbl_create, tm_frame_tbl_destroy,
-        error);
-    if (picotm_error_is_set(error)) {
-        return nullptr;
+    struct tm_frame_tbl* tbl = entry->tbl;
+
+    if (!tbl || (entry->key != key) || !tm_frame_tbl_try_use(tbl)) {
+        /* Skipping the tree walk failed; look up the table in the map. */
+        tbl = lookup_tbl(self, key, error);
+        if (picotm_error_is_set(error)) {
+            return nullptr;
+        }
+        entry->key = key;
+        entry->tbl = tbl;
     }
-    struct tm_frame_tbl* tbl = (struct tm_frame_tbl*)value;
 
     return tbl->frame + frame_tbl_index(addr);
 }
+
+/*
+ * Reclamation
+ *
+ * Frame tables are reclaimed with epochs. Each reader enters the
+ * current epoch before its first look-up in a transaction and leaves
+ * the epoch when the transaction finishes. The epoch counter only
+ * advances when all active readers have entered the current epoch.
+ * Two epochs later, none of the readers that were active at a given
+ * point in time can still hold a pointer they retrieved before that
+ * point.
+ *
+ * Every TM_FRAME_MAP_RECLAIM_INTERVAL transactions, a reader makes
+ * a reclamation step. It
+ *
+ *  - advances the epoch if possible,
+ *  - frees tables that have been retired for two epochs,
+ *  - marks all tables as candidates for reclamation, or
+ *  - retires all tables that are still marked two epochs after
+ *    they have been marked.
+ *
+ * Looking up a marked table resets its state, so only tables that
+ * haven't been used since being marked get reclaimed. Such a table
+ * cannot have locked frames, because all transactions that looked up
+ * the table before it was marked have finished.
+ */
+
+#if !defined(TM_FRAME_MAP_RECLAIM_INTERVAL)
+#define TM_FRAME_MAP_RECLAIM_INTERVAL   (1024)
+#endif
+
+void
+tm_frame_map_register_reader(struct tm_frame_map* self,
+                             struct tm_frame_map_reader* reader)
+{
+    atomic_init(&reader->epoch, 0);
+    reader->nleaves = 0;
+    memset(reader->cache, 0, sizeof(reader->cache));
+    reader->cache_generation = 0;
+    picotm_slist_init_item(&reader->list);
+
+    picotm_spinlock_lock(&self->lock);
+    picotm_slist_enqueue_back(&self->readers, &reader->list);
+    picotm_spinlock_unlock(&self->lock);
+}
+
+void
+tm_frame_map_unregister_reader(struct tm_frame_map* self,
+                               struct tm_frame_map_reader* reader)
+{
+    picotm_spinlock_lock(&self->lock);
+    picotm_slist_dequeue(&reader->list);
+    picotm_spinlock_unlock(&self->lock);
+
+    picotm_slist_uninit_item(&reader->list);
+}
+
+void
+tm_frame_map_enter(struct tm_frame_map* self,
+                   struct tm_frame_map_reader* reader)
+{
+    if (atomic_load_explicit(&reader->epoch, memory_order_relaxed)) {
+        return; /* already entered */
+    }
+
+    unsigned long epoch = atomic_load_explicit(&self->epoch,
+                                               memory_order_acquire);
+    atomic_store_explicit(&reader->epoch, epoch, memory_order_relaxed);
+
+    /* The epoch has to be visible before the first look-up. */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    /* Cached tables might have been retired and freed since the
+     * previous epoch. Tables that get retired from now on cannot be
+     * freed before the reader leaves the epoch. */
+    unsigned long generation = atomic_load_explicit(&self->generation,
+                                                    memory_order_relaxed);
+    if (generation != reader->cache_generation) {
+        memset(reader->cache, 0, sizeof(reader->cache));
+        reader->cache_generation = generation;
+    }
+}
+
+static bool
+is_behind_epoch(const struct picotm_slist* item, void* data)
+{
+    const struct tm_frame_map_reader* reader =
+        picotm_containerof(item, struct tm_frame_map_reader, list);
+    unsigned long epoch = atomic_load_explicit(&reader->epoch,
+                                               memory_order_relaxed);
+
+    return epoch && (epoch != *(const unsigned long*)data);
+}
+
+static unsigned long
+try_advance_epoch(struct tm_frame_map* self)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    unsigned long epoch = atomic_load_explicit(&self->epoch,
+                                               memory_order_relaxed);
+
+    struct picotm_slist* pos = picotm_slist_find_1(&self->readers,
+                                                   is_behind_epoch, &epoch);
+    if (pos != picotm_slist_end(&self->readers)) {
+        return epoch; /* a reader is still active in an earlier epoch */
+    }
+
+    ++epoch;
+    atomic_store_explicit(&self->epoch, epoch, memory_order_release);
+
+    return epoch;
+}
+
+static void
+free_retired_tbls(struct tm_frame_map* self, unsigned long epoch)
+{
+    while (!picotm_slist_is_empty(&self->retired_tbls)) {
+        struct tm_frame_tbl* tbl =
+            tm_frame_tbl_of_slist(picotm_slist_front(&self->retired_tbls));
+        if ((epoch - tbl->retire_epoch) < 2) {
+            break;
+        }
+        picotm_slist_dequeue_front(&self->retired_tbls);
+        tm_frame_tbl_destroy((uintptr_t)tbl, &self->map);
+    }
+}
+
+static void
+mark_tbl(uintptr_t value, unsigned long long key,
+         struct picotm_shared_treemap* treemap, void* data,
+         struct picotm_error* error)
+{
+    struct tm_frame_tbl* tbl = (struct tm_frame_tbl*)value;
+
+    unsigned int state = TM_FRAME_TBL_LIVE;
+    atomic_compare_exchange_strong_explicit(&tbl->state, &state,
+                                            TM_FRAME_TBL_MARKED,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+}
+
+static void
+retire_marked_tbl(uintptr_t value, unsigned long long key,
+                  struct picotm_shared_treemap* treemap, void* data,
+                  struct picotm_error* error)
+{
+    struct tm_frame_tbl* tbl = (struct tm_frame_tbl*)value;
+
+    unsigned int state = TM_FRAME_TBL_MARKED;
+    bool succ = atomic_compare_exchange_strong_explicit(
+        &tbl->state, &state, TM_FRAME_TBL_DEAD,
+        memory_order_relaxed, memory_order_relaxed);
+    if (!succ) {
+        return; /* table has been used since marking */
+    }
+
+    struct tm_frame_map* self = frame_map_of_treemap(treemap);
+
+    /* Concurrent look-ups might have removed the table already. */
+    picotm_shared_treemap_remove_value(treemap, key, value);
+
+    tbl->retire_epoch = *(const unsigned long*)data;
+    picotm_slist_enqueue_back(&self->retired_tbls, &tbl->list);
+
+    atomic_fetch_add_explicit(&self->generation, 1, memory_order_relaxed);
+}
+
+static void
+reclaim(struct tm_frame_map* self)
+{
+    if (!picotm_spinlock_try_lock(&self->lock)) {
+        return; /* another thread is reclaiming */
+    }
+
+    unsigned long epoch = try_advance_epoch(self);
+
+    free_retired_tbls(self, epoch);
+
+    struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+
+    if (!self->has_marked_tbls) {
+        picotm_shared_treemap_for_each_value(&self->map, nullptr, mark_tbl,
+                                             &error);
+        self->mark_epoch = epoch;
+        self->has_marked_tbls = true;
+    } else if ((epoch - self->mark_epoch) >= 2) {
+        picotm_shared_treemap_for_each_value(&self->map, &epoch,
+                                             retire_marked_tbl, &error);
+        self->has_marked_tbls = false;
+    }
+
+    picotm_spinlock_unlock(&self->lock);
+}
+
+void
+tm_frame_map_leave(struct tm_frame_map* self,
+                   struct tm_frame_map_reader* reader)
+{
+    if (!atomic_load_explicit(&reader->epoch, memory_order_relaxed)) {
+        return; /* not entered */
+    }
+
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+
+    if (!(++reader->nleaves % TM_FRAME_MAP_RECLAIM_INTERVAL)) {
+        reclaim(self);
+    }
+}
+
+size_t
+tm_frame_map_memory_usage(struct tm_frame_map* self)
+{
+    return atomic_load_explicit(&self->memory_usage, memory_order_relaxed);
+}
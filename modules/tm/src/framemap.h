@@ -20,6 +20,11 @@
 #pragma once
 
 #include "picotm/picotm-lib-shared-treemap.h"
+#include "picotm/picotm-lib-slist.h"
+#include "picotm/picotm-lib-spinlock.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 /**
  * \cond impl || tm_impl
@@ -30,9 +35,71 @@
 
 struct picotm_error;
 struct tm_frame;
+struct tm_frame_tbl;
 
+#define TM_FRAME_MAP_CACHE_SIZE_BITS    (4)
+#define TM_FRAME_MAP_CACHE_SIZE         (1ul << TM_FRAME_MAP_CACHE_SIZE_BITS)
+
+/**
+ * |struct tm_frame_map_cache_entry| caches the look-up result for a
+ * frame table.
+ */
+struct tm_frame_map_cache_entry {
+    unsigned long long key;
+    struct tm_frame_tbl* tbl;
+};
+
+/**
+ * |struct tm_frame_map_reader| represents a thread that looks up
+ * frames in the frame map.
+ *
+ * A reader enters the frame map's current epoch before its first
+ * look-up in a transaction, and leaves it when the transaction
+ * finishes. Frame tables are only freed after all readers have left
+ * the epochs in which the tables were still reachable.
+ */
+struct tm_frame_map_reader {
+    /* The entered epoch, or 0 if the reader is quiescent. */
+    atomic_ulong epoch;
+
+    /* The number of epochs that the reader left. */
+    unsigned long nleaves;
+
+    /* Direct-mapped cache of recently used frame tables. The cache
+     * is flushed when tables have been retired since it was filled. */
+    struct tm_frame_map_cache_entry cache[TM_FRAME_MAP_CACHE_SIZE];
+    unsigned long cache_generation;
+
+    /* Entry in the frame map's list of readers. */
+    struct picotm_slist list;
+};
+
+/**
+ * |struct tm_frame_map| maps addresses to frames.
+ *
+ * Frames are allocated in tables that cover a contiguous range of
+ * blocks. Tables that haven't been accessed for a while get reclaimed.
+ */
 struct tm_frame_map {
     struct picotm_shared_treemap map;
+
+    /* The current epoch */
+    atomic_ulong epoch;
+
+    /* The memory used by frame tables in bytes */
+    atomic_size_t memory_usage;
+
+    /* Incremented whenever frame tables have been retired. */
+    atomic_ulong generation;
+
+    /* Protects all reclamation fields. */
+    struct picotm_spinlock lock;
+
+    /* reclamation fields */
+    struct picotm_slist readers;
+    struct picotm_slist retired_tbls;
+    unsigned long mark_epoch;
+    bool has_marked_tbls;
 };
 
 void
@@ -41,6 +108,33 @@ tm_frame_map_init(struct tm_frame_map* self);
 void
 tm_frame_map_uninit(struct tm_frame_map* self);
 
+/**
+ * Looks up the frame of an address. The reader must have entered an
+ * epoch with tm_frame_map_enter().
+ */
 struct tm_frame*
-tm_frame_map_lookup(struct tm_frame_map* self, uintptr_t addr,
+tm_frame_map_lookup(struct tm_frame_map* self,
+                    struct tm_frame_map_reader* reader, uintptr_t addr,
                     struct picotm_error* error);
+
+void
+tm_frame_map_register_reader(struct tm_frame_map* self,
+                             struct tm_frame_map_reader* reader);
+
+void
+tm_frame_map_unregister_reader(struct tm_frame_map* self,
+                               struct tm_frame_map_reader* reader);
+
+void
+tm_frame_map_enter(struct tm_frame_map* self,
+                   struct tm_frame_map_reader* reader);
+
+void
+tm_frame_map_leave(struct tm_frame_map* self,
+                   struct tm_frame_map_reader* reader);
+
+/**
+ * Returns the number of bytes currently allocated for frame tables.
+ */
+size_t
+tm_frame_map_memory_usage(struct tm_frame_map* self);
@@ -88,6 +88,25 @@ tm_module_undo(struct tm_module* self, struct picotm_error* error)
     tm_vmem_tx_undo(&self->tx, error);
 }
 
+static uintptr_t
+tm_module_savepoint(struct tm_module* self)
+{
+    return tm_vmem_tx_savepoint(&self->tx);
+}
+
+static void
+tm_module_rollback_to_savepoint(struct tm_module* self, uintptr_t mark,
+                                struct picotm_error* error)
+{
+    tm_vmem_tx_rollback_to_savepoint(&self->tx, mark, error);
+}
+
+static void
+tm_module_release_savepoint(struct tm_module* self, uintptr_t mark)
+{
+    tm_vmem_tx_release_savepoint(&self->tx, mark);
+}
+
 static void
 tm_module_finish(struct tm_module* self, struct picotm_error* error)
 {
@@ -116,6 +135,28 @@ undo_cb(void* data, struct picotm_error* error)
     tm_module_undo(module, error);
 }
 
+static uintptr_t
+savepoint_cb(void* data, struct picotm_error* error)
+{
+    struct tm_module* module = data;
+    return tm_module_savepoint(module);
+}
+
+static void
+rollback_to_savepoint_cb(uintptr_t mark, void* data,
+                         struct picotm_error* error)
+{
+    struct tm_module* module = data;
+    tm_module_rollback_to_savepoint(module, mark, error);
+}
+
+static void
+release_savepoint_cb(uintptr_t mark, void* data, struct picotm_error* error)
+{
+    struct tm_module* module = data;
+    tm_module_release_savepoint(module, mark);
+}
+
 static void
 finish_cb(void* data, struct picotm_error* error)
 {
@@ -136,7 +177,10 @@ init_tm_module(struct tm_module* module, struct picotm_error* error)
         .apply = apply_cb,
         .undo = undo_cb,
         .finish = finish_cb,
-        .release = release_cb
+        .release = release_cb,
+        .savepoint = savepoint_cb,
+        .rollback_to_savepoint = rollback_to_savepoint_cb,
+        .release_savepoint = release_savepoint_cb
     };
 
     struct tm_vmem* vmem = PICOTM_GLOBAL_STATE_REF(vmem, error);
@@ -172,11 +216,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(tm_module)
 static struct tm_vmem_tx*
 get_vmem_tx(struct picotm_error* error)
 {
-    struct tm_module* module = PICOTM_THREAD_STATE_ACQUIRE(tm_module, true,
-                                                           error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct tm_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(tm_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->tx.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
@@ -238,3 +291,18 @@ tm_module_privatize_c(uintptr_t addr, int c, unsigned long flags,
     }
     tm_vmem_tx_privatize_c(vmem_tx, addr, c, flags, error);
 }
+
+size_t
+tm_module_get_memory_usage(struct picotm_error* error)
+{
+    struct tm_vmem* vmem = PICOTM_GLOBAL_STATE_REF(vmem, error);
+    if (picotm_error_is_set(error)) {
+        return 0;
+    }
+
+    size_t memory_usage = tm_vmem_memory_usage(vmem);
+
+    PICOTM_GLOBAL_STATE_UNREF(vmem);
+
+    return memory_usage;
+}
@@ -50,3 +50,6 @@ tm_module_privatize(uintptr_t addr, size_t siz, unsigned long flags,
 void
 tm_module_privatize_c(uintptr_t addr, int c, unsigned long flags,
                       struct picotm_error* error);
+
+size_t
+tm_module_get_memory_usage(struct picotm_error* error);
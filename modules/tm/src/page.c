@@ -25,11 +25,13 @@
 #include "vmem.h"
 
 void
-tm_page_init(struct tm_page* page, size_t block_index)
+tm_page_init(struct tm_page* page, struct tm_frame* frame)
 {
-    page->flags = block_index << TM_BLOCK_SIZE_BITS;
+    page->flags = tm_frame_block_index(frame) << TM_BLOCK_SIZE_BITS;
+    page->frame = frame;
     picotm_rwstate_init(&page->rwstate);
     page->buf_bits = 0;
+    page->savepoint = 0;
     picotm_slist_init_item(&page->list);
 }
 
@@ -49,9 +51,9 @@ tm_page_buffer(struct tm_page* page)
 }
 
 static bool
-all_buf_bits_set(unsigned long bits)
+all_buf_bits_set(tm_block_bitmap bits)
 {
-    return bits == TM_BLOCK_OFFSET_MASK;
+    return bits == TM_BLOCK_BITMAP_ALL;
 }
 
 bool
@@ -61,17 +63,10 @@ tm_page_is_complete(const struct tm_page* page)
 }
 
 void
-tm_page_ld(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_ld(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
            struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return;
-    }
+    struct tm_frame* frame = page->frame;
 
     if (all_buf_bits_set(bits) && !page->buf_bits) {
         void* mem = tm_frame_buffer(frame);
@@ -81,7 +76,7 @@ tm_page_ld(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
               uint8_t* buf_beg = picotm_arraybeg(page->buf);
         const uint8_t* buf_end = picotm_arrayend(page->buf);
         const uint8_t* mem = tm_frame_buffer(frame);
-        unsigned long bit = 1ul;
+        tm_block_bitmap bit = 1;
 
         for (uint8_t* buf = buf_beg; buf < buf_end; ++buf, ++mem, bit <<= 1) {
             if ((bits & bit) && !(page->buf_bits & bit)) {
@@ -91,28 +86,19 @@ tm_page_ld(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
     }
 
     page->buf_bits |= bits;
-
-    tm_vmem_release_frame(vmem, frame);
 }
 
 bool
-tm_page_ld_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem* vmem,
+tm_page_ld_c(struct tm_page* page, tm_block_bitmap bits, int c, struct tm_vmem* vmem,
              struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return false;
-    }
+    struct tm_frame* frame = page->frame;
 
           uint8_t* buf_beg = picotm_arraybeg(page->buf);
     const uint8_t* buf_end = picotm_arrayend(page->buf);
           uint8_t* buf;
     const uint8_t* mem = tm_frame_buffer(frame);
-    unsigned long bit = 1ul;
+    tm_block_bitmap bit = 1;
 
     for (buf = buf_beg; buf < buf_end; ++buf, ++mem, bit <<= 1) {
         if ((bits & bit) && !(page->buf_bits & bit)) {
@@ -126,23 +112,14 @@ tm_page_ld_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem* vm
         }
     }
 
-    tm_vmem_release_frame(vmem, frame);
-
     return buf != buf_end;
 }
 
 void
-tm_page_st(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_st(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
            struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return;
-    }
+    struct tm_frame* frame = page->frame;
 
     if (all_buf_bits_set(bits) && all_buf_bits_set(page->buf_bits)) {
         void* mem = tm_frame_buffer(frame);
@@ -152,7 +129,7 @@ tm_page_st(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
         const uint8_t* buf_beg = picotm_arraybeg(page->buf);
         const uint8_t* buf_end = picotm_arrayend(page->buf);
               uint8_t* mem = tm_frame_buffer(frame);
-        unsigned long bit = 1ul;
+        tm_block_bitmap bit = 1;
 
         for (const uint8_t* buf = buf_beg;
                             buf < buf_end;
@@ -162,22 +139,13 @@ tm_page_st(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
             }
         }
     }
-
-    tm_vmem_release_frame(vmem, frame);
 }
 
 void
-tm_page_xchg(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_xchg(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
              struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return;
-    }
+    struct tm_frame* frame = page->frame;
 
     if (all_buf_bits_set(bits) && all_buf_bits_set(page->buf_bits)) {
         uint8_t buf[TM_BLOCK_SIZE];
@@ -192,7 +160,7 @@ tm_page_xchg(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
               uint8_t* buf_beg = picotm_arraybeg(page->buf);
         const uint8_t* buf_end = picotm_arrayend(page->buf);
               uint8_t* mem = tm_frame_buffer(frame);
-        unsigned long bit = 1ul;
+        tm_block_bitmap bit = 1;
 
         for (uint8_t* buf = buf_beg; buf < buf_end; ++buf, ++mem, bit <<= 1) {
             if ((bits & bit) && (page->buf_bits & bit)) {
@@ -202,28 +170,19 @@ tm_page_xchg(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
             }
         }
     }
-
-    tm_vmem_release_frame(vmem, frame);
 }
 
 bool
-tm_page_xchg_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem* vmem,
+tm_page_xchg_c(struct tm_page* page, tm_block_bitmap bits, int c, struct tm_vmem* vmem,
                struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return false;
-    }
+    struct tm_frame* frame = page->frame;
 
           uint8_t* buf_beg = picotm_arraybeg(page->buf);
     const uint8_t* buf_end = picotm_arrayend(page->buf);
           uint8_t* buf;
           uint8_t* mem = tm_frame_buffer(frame);
-    unsigned long bit = 1ul;
+    tm_block_bitmap bit = 1;
 
     for (buf = buf_beg; (buf < buf_end) && (*mem != c); ++buf, ++mem, bit <<= 1) {
         if ((bits & bit) && (page->buf_bits & bit)) {
@@ -233,8 +192,6 @@ tm_page_xchg_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem*
         }
     }
 
-    tm_vmem_release_frame(vmem, frame);
-
     return buf != buf_end;
 }
 
@@ -242,59 +199,19 @@ void
 tm_page_try_rdlock_frame(struct tm_page* page, struct tm_vmem* vmem,
                          struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        return;
-    }
-    tm_frame_try_rdlock(frame, &page->rwstate, error);
-    if (picotm_error_is_set(error)) {
-        goto err_tm_frame_lock;
-    }
-    tm_vmem_release_frame(vmem, frame);
-
-    return;
-
-err_tm_frame_lock:
-    tm_vmem_release_frame(vmem, frame);
+    tm_frame_try_rdlock(page->frame, &page->rwstate, error);
 }
 
 void
 tm_page_try_wrlock_frame(struct tm_page* page, struct tm_vmem* vmem,
                          struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        return;
-    }
-    tm_frame_try_wrlock(frame, &page->rwstate, error);
-    if (picotm_error_is_set(error)) {
-        goto err_tm_frame_lock;
-    }
-    tm_vmem_release_frame(vmem, frame);
-
-    return;
-
-err_tm_frame_lock:
-    tm_vmem_release_frame(vmem, frame);
+    tm_frame_try_wrlock(page->frame, &page->rwstate, error);
 }
 
 void
 tm_page_unlock_frame(struct tm_page* page, struct tm_vmem* vmem,
                      struct picotm_error* error)
 {
-    struct tm_frame* frame =
-        tm_vmem_acquire_frame_by_block(vmem, tm_page_block_index(page),
-                                       error);
-    if (picotm_error_is_set(error)) {
-        /* There's no legal way we should end up here! */
-        picotm_error_mark_as_non_recoverable(error);
-        return;
-    }
-
-    tm_frame_unlock(frame, &page->rwstate);
-    tm_vmem_release_frame(vmem, frame);
+    tm_frame_unlock(page->frame, &page->rwstate);
 }
@@ -41,6 +41,9 @@ struct tm_page {
     /** Block index and flag bits */
     uintptr_t flags;
 
+    /** The page's frame */
+    struct tm_frame* frame;
+
     /** Lock state wrt. to frame lock */
     struct picotm_rwstate rwstate;
 
@@ -48,7 +51,10 @@ struct tm_page {
     uint8_t buf[TM_BLOCK_SIZE];
 
     /** Bitmap of the valid fields in buf. */
-    uint8_t buf_bits;
+    tm_block_bitmap buf_bits;
+
+    /** The vmem transaction's savepoint when the page has been saved */
+    unsigned long savepoint;
 
     /** Entry into allocator lists */
     struct picotm_slist list;
@@ -67,7 +73,7 @@ tm_page_of_const_slist(const struct picotm_slist* item)
 }
 
 void
-tm_page_init(struct tm_page* page, size_t block_index);
+tm_page_init(struct tm_page* page, struct tm_frame* frame);
 
 void
 tm_page_uninit(struct tm_page* page);
@@ -91,22 +97,22 @@ void*
 tm_page_buffer(struct tm_page* page);
 
 void
-tm_page_ld(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_ld(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
            struct picotm_error* error);
 
 bool
-tm_page_ld_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem* vmem,
+tm_page_ld_c(struct tm_page* page, tm_block_bitmap bits, int c, struct tm_vmem* vmem,
              struct picotm_error* error);
 
 void
-tm_page_st(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_st(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
            struct picotm_error* error);
 
 void
-tm_page_xchg(struct tm_page* page, unsigned long bits, struct tm_vmem* vmem,
+tm_page_xchg(struct tm_page* page, tm_block_bitmap bits, struct tm_vmem* vmem,
              struct picotm_error* error);
 bool
-tm_page_xchg_c(struct tm_page* page, unsigned long bits, int c, struct tm_vmem* vmem,
+tm_page_xchg_c(struct tm_page* page, tm_block_bitmap bits, int c, struct tm_vmem* vmem,
                struct picotm_error* error);
 
 static inline bool
@@ -90,3 +90,17 @@ __picotm_tm_privatize_c(uintptr_t addr, int c, unsigned long flags)
         picotm_recover_from_error(&error);
     } while (true);
 }
+
+PICOTM_EXPORT
+size_t
+picotm_tm_get_memory_usage()
+{
+    do {
+        struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+        size_t memory_usage = tm_module_get_memory_usage(&error);
+        if (!picotm_error_is_set(&error)) {
+            return memory_usage;
+        }
+        picotm_recover_from_error(&error);
+    } while (true);
+}
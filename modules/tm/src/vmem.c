@@ -35,22 +35,52 @@ tm_vmem_uninit(struct tm_vmem* vmem)
 }
 
 struct tm_frame*
-tm_vmem_acquire_frame_by_block(struct tm_vmem* vmem, size_t block_index,
+tm_vmem_acquire_frame_by_block(struct tm_vmem* vmem,
+                               struct tm_frame_map_reader* reader,
+                               size_t block_index,
                                struct picotm_error* error)
 {
-    return tm_vmem_acquire_frame_by_address(vmem,
+    return tm_vmem_acquire_frame_by_address(vmem, reader,
                                             block_index << TM_BLOCK_SIZE_BITS,
                                             error);
 }
 
 struct tm_frame*
-tm_vmem_acquire_frame_by_address(struct tm_vmem* vmem, uintptr_t addr,
-                                 struct picotm_error* error)
+tm_vmem_acquire_frame_by_address(struct tm_vmem* vmem,
+                                 struct tm_frame_map_reader* reader,
+                                 uintptr_t addr, struct picotm_error* error)
 {
-    return tm_frame_map_lookup(&vmem->frame_map, addr, error);
+    return tm_frame_map_lookup(&vmem->frame_map, reader, addr, error);
 }
 
 void
-tm_vmem_release_frame(struct tm_vmem* vmem, struct tm_frame* frame)
+tm_vmem_register_tx(struct tm_vmem* vmem,
+                    struct tm_frame_map_reader* reader)
 {
+    tm_frame_map_register_reader(&vmem->frame_map, reader);
+}
+
+void
+tm_vmem_unregister_tx(struct tm_vmem* vmem,
+                      struct tm_frame_map_reader* reader)
+{
+    tm_frame_map_unregister_reader(&vmem->frame_map, reader);
+}
+
+void
+tm_vmem_begin_tx(struct tm_vmem* vmem, struct tm_frame_map_reader* reader)
+{
+    tm_frame_map_enter(&vmem->frame_map, reader);
+}
+
+void
+tm_vmem_end_tx(struct tm_vmem* vmem, struct tm_frame_map_reader* reader)
+{
+    tm_frame_map_leave(&vmem->frame_map, reader);
+}
+
+size_t
+tm_vmem_memory_usage(struct tm_vmem* vmem)
+{
+    return tm_frame_map_memory_usage(&vmem->frame_map);
 }
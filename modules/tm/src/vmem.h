@@ -46,13 +46,47 @@ tm_vmem_init(struct tm_vmem* vmem);
 void
 tm_vmem_uninit(struct tm_vmem* vmem);
 
+/**
+ * Returns the frame of a block. The frame remains valid until the
+ * transaction ends with tm_vmem_end_tx().
+ */
 struct tm_frame*
-tm_vmem_acquire_frame_by_block(struct tm_vmem* vmem, size_t block_index,
+tm_vmem_acquire_frame_by_block(struct tm_vmem* vmem,
+                               struct tm_frame_map_reader* reader,
+                               size_t block_index,
                                struct picotm_error* error);
 
+/**
+ * Returns the frame of an address. The frame remains valid until the
+ * transaction ends with tm_vmem_end_tx().
+ */
 struct tm_frame*
-tm_vmem_acquire_frame_by_address(struct tm_vmem* vmem, uintptr_t addr,
-                                 struct picotm_error* error);
+tm_vmem_acquire_frame_by_address(struct tm_vmem* vmem,
+                                 struct tm_frame_map_reader* reader,
+                                 uintptr_t addr, struct picotm_error* error);
 
 void
-tm_vmem_release_frame(struct tm_vmem* vmem, struct tm_frame* frame);
+tm_vmem_register_tx(struct tm_vmem* vmem,
+                    struct tm_frame_map_reader* reader);
+
+void
+tm_vmem_unregister_tx(struct tm_vmem* vmem,
+                      struct tm_frame_map_reader* reader);
+
+/**
+ * Announces that a transaction is about to acquire frames.
+ */
+void
+tm_vmem_begin_tx(struct tm_vmem* vmem, struct tm_frame_map_reader* reader);
+
+/**
+ * Announces that a transaction has released all its frames.
+ */
+void
+tm_vmem_end_tx(struct tm_vmem* vmem, struct tm_frame_map_reader* reader);
+
+/**
+ * Returns the number of bytes allocated for frames.
+ */
+size_t
+tm_vmem_memory_usage(struct tm_vmem* vmem);
@@ -20,10 +20,13 @@
 #include "vmem_tx.h"
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-ptr.h"
+#include "picotm/picotm-lib-tab.h"
 #include "picotm/picotm-tm.h"
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include "page.h"
+#include "vmem.h"
 
 void
 tm_vmem_tx_init(struct tm_vmem_tx* vmem_tx, struct tm_vmem* vmem,
@@ -32,8 +35,58 @@ tm_vmem_tx_init(struct tm_vmem_tx* vmem_tx, struct tm_vmem* vmem,
     vmem_tx->vmem = vmem;
     vmem_tx->module = module;
 
+    tm_vmem_register_tx(vmem, &vmem_tx->reader);
+
     picotm_slist_init_head(&vmem_tx->active_pages);
-    picotm_slist_init_head(&vmem_tx->alloced_pages);
+
+    vmem_tx->slabs = nullptr;
+    vmem_tx->slab = nullptr;
+    vmem_tx->slab_npages = 0;
+    vmem_tx->nslabs = 0;
+
+    vmem_tx->pagetab = nullptr;
+    vmem_tx->pagetabbits = 0;
+    vmem_tx->npages = 0;
+    vmem_tx->active_pages_is_sorted = true;
+
+    vmem_tx->savetab = nullptr;
+    vmem_tx->savetablen = 0;
+    vmem_tx->savetabsiz = 0;
+    vmem_tx->savepoint = 0;
+    vmem_tx->nsavepoints = 0;
+}
+
+/*
+ * Page allocator
+ *
+ * Pages are allocated from slabs of contiguous page objects. A
+ * transaction takes pages from its slabs in order and releases all
+ * of them at once when it finishes. Slabs are kept for following
+ * transactions, except for those beyond TM_PAGE_SLABS_HIGH_WATER,
+ * which a large transaction might have allocated.
+ */
+
+#if !defined(TM_PAGE_SLAB_NPAGES)
+#define TM_PAGE_SLAB_NPAGES         (64)
+#endif
+
+#if !defined(TM_PAGE_SLABS_HIGH_WATER)
+#define TM_PAGE_SLABS_HIGH_WATER    (16)
+#endif
+
+struct tm_page_slab {
+    struct tm_page_slab* next;
+    struct tm_page page[TM_PAGE_SLAB_NPAGES];
+};
+
+static void
+free_slabs(struct tm_page_slab* slab)
+{
+    while (slab) {
+        struct tm_page_slab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
 }
 
 static void
@@ -41,7 +94,6 @@ cleanup_page(struct picotm_slist* item)
 {
     struct tm_page* page = tm_page_of_slist(item);
     picotm_slist_uninit_item(&page->list);
-    free(page);
 }
 
 void
@@ -50,54 +102,148 @@ tm_vmem_tx_uninit(struct tm_vmem_tx* vmem_tx)
     picotm_slist_cleanup_0(&vmem_tx->active_pages, cleanup_page);
     picotm_slist_uninit_head(&vmem_tx->active_pages);
 
-    picotm_slist_cleanup_0(&vmem_tx->alloced_pages, cleanup_page);
-    picotm_slist_uninit_head(&vmem_tx->alloced_pages);
+    free_slabs(vmem_tx->slabs);
+    free(vmem_tx->pagetab);
+    picotm_tabfree(vmem_tx->savetab);
+
+    tm_vmem_unregister_tx(vmem_tx->vmem, &vmem_tx->reader);
 }
 
 static struct tm_page*
 alloc_page(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
 {
-    struct tm_page* page;
+    if (!vmem_tx->slab || (vmem_tx->slab_npages == TM_PAGE_SLAB_NPAGES)) {
 
-    if (picotm_slist_is_empty(&vmem_tx->alloced_pages)) {
-        page = malloc(sizeof(*page));
-        if (!page) {
-            picotm_error_set_error_code(error, PICOTM_OUT_OF_MEMORY);
-            return nullptr;
+        /* Continue with the next slab; allocate it if necessary. */
+
+        struct tm_page_slab* next = vmem_tx->slab ? vmem_tx->slab->next
+                                                  : vmem_tx->slabs;
+        if (!next) {
+            next = malloc(sizeof(*next));
+            if (!next) {
+                picotm_error_set_error_code(error, PICOTM_OUT_OF_MEMORY);
+                return nullptr;
+            }
+            next->next = nullptr;
+
+            if (vmem_tx->slab) {
+                vmem_tx->slab->next = next;
+            } else {
+                vmem_tx->slabs = next;
+            }
+            ++vmem_tx->nslabs;
         }
-    } else {
-        page = tm_page_of_slist(picotm_slist_front(&vmem_tx->alloced_pages));
-        picotm_slist_dequeue_front(&vmem_tx->alloced_pages);
+
+        vmem_tx->slab = next;
+        vmem_tx->slab_npages = 0;
     }
 
-    return page;
+    return vmem_tx->slab->page + vmem_tx->slab_npages++;
 }
 
 static void
-free_page(struct tm_vmem_tx* vmem_tx, struct tm_page* page)
+free_all_pages(struct tm_vmem_tx* vmem_tx)
 {
-    picotm_slist_enqueue_front(&vmem_tx->alloced_pages, &page->list);
+    vmem_tx->slab = nullptr;
+    vmem_tx->slab_npages = 0;
+
+    if (vmem_tx->nslabs <= TM_PAGE_SLABS_HIGH_WATER) {
+        return;
+    }
+
+    /* Shrink the page allocator to its high-water mark. */
+
+    struct tm_page_slab* last = vmem_tx->slabs;
+    for (size_t i = 1; i < TM_PAGE_SLABS_HIGH_WATER; ++i) {
+        last = last->next;
+    }
+    free_slabs(last->next);
+    last->next = nullptr;
+    vmem_tx->nslabs = TM_PAGE_SLABS_HIGH_WATER;
+}
+
+/*
+ * Page index
+ *
+ * The transaction's active pages are indexed by block index in an
+ * open-addressing hash table with linear probing. The table is kept
+ * at most half full, so each look-up finds the page or an empty slot
+ * after a few probes. Pages are only removed from the table when the
+ * transaction finishes.
+ */
+
+static const unsigned int PAGETAB_MIN_BITS = 6;
+
+static size_t
+pagetab_hash(size_t block_index, unsigned int bits)
+{
+    /* Fibonacci hashing takes the upper bits of the product. This
+     * spreads blocks that are accessed with a power-of-two stride. */
+    return (UINT64_C(0x9e3779b97f4a7c15) * block_index) >> (64 - bits);
 }
 
-static _Bool
-find_page_by_block_index(const struct tm_page* page, size_t block_index,
-                         struct tm_page** prev)
+static struct tm_page**
+find_pagetab_slot(struct tm_page** pagetab, unsigned int bits,
+                  size_t block_index)
+{
+    size_t mask = ((size_t)1 << bits) - 1;
+
+    for (size_t i = pagetab_hash(block_index, bits);; i = (i + 1) & mask) {
+        if (!pagetab[i] || (tm_page_block_index(pagetab[i]) == block_index)) {
+            return pagetab + i;
+        }
+    }
+}
+
+static void
+grow_pagetab(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
 {
-    if (tm_page_block_index(page) >= block_index) {
-        return true; /* stop iterating */
+    unsigned int bits = vmem_tx->pagetab ? vmem_tx->pagetabbits + 1
+                                         : PAGETAB_MIN_BITS;
+
+    struct tm_page** pagetab = calloc((size_t)1 << bits, sizeof(*pagetab));
+    if (!pagetab) {
+        picotm_error_set_error_code(error, PICOTM_OUT_OF_MEMORY);
+        return;
+    }
+
+    if (vmem_tx->pagetab) {
+        size_t pagetabsiz = (size_t)1 << vmem_tx->pagetabbits;
+        for (size_t i = 0; i < pagetabsiz; ++i) {
+            struct tm_page* page = vmem_tx->pagetab[i];
+            if (page) {
+                *find_pagetab_slot(pagetab, bits,
+                                   tm_page_block_index(page)) = page;
+            }
+        }
+        free(vmem_tx->pagetab);
     }
-    *prev = (struct tm_page*)page;
-    return false;
+
+    vmem_tx->pagetab = pagetab;
+    vmem_tx->pagetabbits = bits;
 }
 
-static _Bool
-find_page_by_block_index_cb(const struct picotm_slist* item,
-                            void* data1, void* data2)
+static void
+clear_pagetab(struct tm_vmem_tx* vmem_tx)
 {
-    const struct tm_page* page = tm_page_of_const_slist(item);
-    size_t* block_index = data1;
-    struct tm_page** prev = data2;
-    return find_page_by_block_index(page, *block_index, prev);
+    if (!vmem_tx->npages) {
+        return; /* table is empty */
+    }
+
+    size_t pagetabsiz = (size_t)1 << vmem_tx->pagetabbits;
+
+    if ((pagetabsiz > ((size_t)8 << PAGETAB_MIN_BITS)) &&
+        (pagetabsiz > 8 * vmem_tx->npages)) {
+        /* The table grew for an earlier, larger transaction. We don't
+         * want to clear all of it after each small transaction. */
+        free(vmem_tx->pagetab);
+        vmem_tx->pagetab = nullptr;
+        vmem_tx->pagetabbits = 0;
+    } else {
+        memset(vmem_tx->pagetab, 0, pagetabsiz * sizeof(*vmem_tx->pagetab));
+    }
+
+    vmem_tx->npages = 0;
 }
 
 static struct tm_page*
@@ -106,40 +252,122 @@ acquire_page_by_block(struct tm_vmem_tx* vmem_tx, size_t block_index,
 {
     /* Return existing page, if there is one... */
 
-    struct tm_page* prev = nullptr;
-
-    struct picotm_slist* pos = picotm_slist_find_2(&vmem_tx->active_pages,
-                                                   find_page_by_block_index_cb,
-                                                   &block_index, &prev);
-    if (pos != picotm_slist_end(&vmem_tx->active_pages)) {
-        struct tm_page* page = tm_page_of_slist(pos);
-        if (tm_page_block_index(page) == block_index) {
+    if (vmem_tx->pagetab) {
+        struct tm_page* page = *find_pagetab_slot(vmem_tx->pagetab,
+                                                  vmem_tx->pagetabbits,
+                                                  block_index);
+        if (page) {
             return page;
         }
     }
 
     /* ...or create a new page that refers to the corresponding frame. */
 
+    if (!vmem_tx->npages) {
+        tm_vmem_begin_tx(vmem_tx->vmem, &vmem_tx->reader);
+    }
+
+    if (!vmem_tx->pagetab ||
+        ((vmem_tx->npages + 1) > ((size_t)1 << (vmem_tx->pagetabbits - 1)))) {
+        grow_pagetab(vmem_tx, error);
+        if (picotm_error_is_set(error)) {
+            return nullptr;
+        }
+    }
+
+    struct tm_frame* frame = tm_vmem_acquire_frame_by_block(vmem_tx->vmem,
+                                                            &vmem_tx->reader,
+                                                            block_index,
+                                                            error);
+    if (picotm_error_is_set(error)) {
+        return nullptr;
+    }
+
     struct tm_page* page = alloc_page(vmem_tx, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
 
-    tm_page_init(page, block_index);
+    tm_page_init(page, frame);
 
-    /* The list of active pages is sorted by block index, so we
-     * insert after the last page with a smaller block index, or
-     * at the list's beginning. */
+    *find_pagetab_slot(vmem_tx->pagetab, vmem_tx->pagetabbits,
+                       block_index) = page;
+    ++vmem_tx->npages;
 
-    if (prev) {
-        picotm_slist_enqueue_after(&prev->list, &page->list);
-    } else {
-        picotm_slist_enqueue_front(&vmem_tx->active_pages, &page->list);
-    }
+    /* The list of active pages gets sorted by block index before
+     * the transaction applies or undoes its pages. */
+    picotm_slist_enqueue_front(&vmem_tx->active_pages, &page->list);
+    vmem_tx->active_pages_is_sorted = false;
 
     return page;
 }
 
+/* Merges the sorted list of pages at src into the sorted list at dst
+ * by block index. The list at src is empty afterwards. */
+static void
+merge_pages(struct picotm_slist* dst, struct picotm_slist* src)
+{
+    struct picotm_slist* prev = dst;
+
+    while (!picotm_slist_is_empty(src)) {
+        struct picotm_slist* item = picotm_slist_begin(src);
+        size_t block_index = tm_page_block_index(tm_page_of_slist(item));
+
+        struct picotm_slist* next = picotm_slist_next(prev);
+        while ((next != picotm_slist_end(dst)) &&
+               (tm_page_block_index(tm_page_of_slist(next)) <= block_index)) {
+            prev = next;
+            next = picotm_slist_next(prev);
+        }
+
+        picotm_slist_dequeue_front(src);
+        picotm_slist_enqueue_after(prev, item);
+        prev = item;
+    }
+}
+
+static void
+sort_active_pages(struct tm_vmem_tx* vmem_tx)
+{
+    if (vmem_tx->active_pages_is_sorted) {
+        return;
+    }
+
+    struct picotm_slist* head = &vmem_tx->active_pages;
+
+    /* Bottom-up merge sort; run[i] holds a sorted list of 2^i pages. */
+    struct picotm_slist run[sizeof(size_t) * 8];
+    size_t nruns = 0;
+
+    struct picotm_slist carry;
+    picotm_slist_init_head(&carry);
+
+    while (!picotm_slist_is_empty(head)) {
+        struct picotm_slist* item = picotm_slist_begin(head);
+        picotm_slist_dequeue_front(head);
+        picotm_slist_enqueue_front(&carry, item);
+
+        size_t i = 0;
+        for (; (i < nruns) && !picotm_slist_is_empty(run + i); ++i) {
+            merge_pages(&carry, run + i);
+        }
+        if (i == nruns) {
+            picotm_slist_init_head(run + i);
+            ++nruns;
+        }
+        merge_pages(run + i, &carry);
+    }
+
+    for (size_t i = 0; i < nruns; ++i) {
+        merge_pages(head, run + i);
+        picotm_slist_uninit_head(run + i);
+    }
+
+    picotm_slist_uninit_head(&carry);
+
+    vmem_tx->active_pages_is_sorted = true;
+}
+
 static struct tm_page*
 acquire_page_by_address(struct tm_vmem_tx* vmem_tx, uintptr_t addr,
                         struct picotm_error* error)
@@ -153,26 +381,148 @@ ulmin(unsigned long lhs, unsigned long rhs)
     return lhs < rhs ? lhs : rhs;
 }
 
-static unsigned long
+static tm_block_bitmap
 copy_all_bits(void)
 {
-    return TM_BLOCK_OFFSET_MASK;
+    return TM_BLOCK_BITMAP_ALL;
 }
 
-static unsigned long
+static tm_block_bitmap
 copy_bits(uintptr_t addr, size_t siz)
 {
-    unsigned long bits = copy_all_bits(); /* Set all bits. */
+    if (!siz) {
+        return 0;
+    }
+
+    tm_block_bitmap bits = copy_all_bits(); /* Set all bits. */
 
     /* Don't copy more than siz or block-size bytes. */
     bits >>= TM_BLOCK_SIZE - ulmin(siz, TM_BLOCK_SIZE);
     /* Start copying at byte. */
-    bits <<= addr - picotm_address_floor(addr, TM_BLOCK_SIZE);
+    bits <<= tm_block_offset_at(addr);
 
     /* Filter out bits within the current page. */
     return bits & copy_all_bits();
 }
 
+/*
+ * Savepoints
+ *
+ * After a savepoint, each page's content is saved before the first
+ * store to the page. Rolling back to the savepoint restores the saved
+ * contents in reverse order. Locks acquired since the savepoint remain
+ * held.
+ */
+
+static struct tm_page_save*
+append_save(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
+{
+    if (vmem_tx->savetablen == vmem_tx->savetabsiz) {
+
+        size_t newsavetabsiz = vmem_tx->savetabsiz ? 2 * vmem_tx->savetabsiz
+                                                   : 16;
+
+        void* tmp = picotm_tabresize(vmem_tx->savetab, vmem_tx->savetabsiz,
+                                     newsavetabsiz,
+                                     sizeof(vmem_tx->savetab[0]), error);
+        if (picotm_error_is_set(error)) {
+            return nullptr;
+        }
+        vmem_tx->savetab = tmp;
+        vmem_tx->savetabsiz = newsavetabsiz;
+    }
+
+    return vmem_tx->savetab + vmem_tx->savetablen++;
+}
+
+static void
+save_page(struct tm_vmem_tx* vmem_tx, struct tm_page* page,
+          struct picotm_error* error)
+{
+    if (!vmem_tx->nsavepoints || (page->savepoint == vmem_tx->savepoint)) {
+        return; /* no savepoint or page already saved */
+    }
+
+    struct tm_page_save* save = append_save(vmem_tx, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+    save->page = page;
+    memcpy(save->buf, tm_page_buffer(page), sizeof(save->buf));
+    save->buf_bits = page->buf_bits;
+
+    page->savepoint = vmem_tx->savepoint;
+}
+
+static void
+save_privatization(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
+{
+    if (!vmem_tx->nsavepoints) {
+        return;
+    }
+
+    /* Privatized memory is modified directly. We mark the
+     * position, so we can detect this during roll-backs. */
+    struct tm_page_save* save = append_save(vmem_tx, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+    save->page = nullptr;
+}
+
+uintptr_t
+tm_vmem_tx_savepoint(struct tm_vmem_tx* vmem_tx)
+{
+    ++vmem_tx->savepoint;
+    ++vmem_tx->nsavepoints;
+
+    return vmem_tx->savetablen;
+}
+
+void
+tm_vmem_tx_rollback_to_savepoint(struct tm_vmem_tx* vmem_tx, uintptr_t mark,
+                                 struct picotm_error* error)
+{
+    const struct tm_page_save* beg = vmem_tx->savetab + mark;
+    const struct tm_page_save* end = vmem_tx->savetab + vmem_tx->savetablen;
+
+    for (const struct tm_page_save* pos = beg; pos < end; ++pos) {
+        if (!pos->page) {
+            /* Only restarting the whole transaction reverts
+             * privatized memory. */
+            picotm_error_set_conflicting(error, nullptr);
+            return;
+        }
+    }
+
+    while (beg < end) {
+        --end;
+        memcpy(tm_page_buffer(end->page), end->buf, sizeof(end->buf));
+        end->page->buf_bits = end->buf_bits;
+    }
+
+    vmem_tx->savetablen = mark;
+
+    /* The retried transaction saves its pages again. */
+    ++vmem_tx->savepoint;
+}
+
+void
+tm_vmem_tx_release_savepoint(struct tm_vmem_tx* vmem_tx, uintptr_t mark)
+{
+    assert(vmem_tx->nsavepoints);
+    assert(mark <= vmem_tx->savetablen);
+
+    --vmem_tx->nsavepoints;
+
+    /* The saved contents since 'mark' belong to the parent's savepoint
+     * now. Without any savepoint, we neither need them nor save pages
+     * any longer. */
+    if (!vmem_tx->nsavepoints) {
+        vmem_tx->savetablen = 0;
+    }
+}
+
 static void
 prepare_page_ld(struct tm_page* page, uintptr_t addr, size_t siz,
                 struct tm_vmem* vmem,
@@ -271,6 +621,10 @@ tm_vmem_tx_st(struct tm_vmem_tx* vmem_tx, uintptr_t addr, const void* buf,
         if (picotm_error_is_set(error)) {
             return;
         }
+        save_page(vmem_tx, page, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
 
         uintptr_t page_addr = tm_page_address(page);
         size_t page_head = addr - page_addr;
@@ -316,6 +670,10 @@ tm_vmem_tx_ldst(struct tm_vmem_tx* vmem_tx, uintptr_t laddr, uintptr_t saddr,
         if (picotm_error_is_set(error)) {
             return;
         }
+        save_page(vmem_tx, spage, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
 
         uintptr_t spage_addr = tm_page_address(spage);
         size_t spage_head = saddr - spage_addr;
@@ -413,6 +771,11 @@ void
 tm_vmem_tx_privatize(struct tm_vmem_tx* vmem_tx, uintptr_t addr, size_t siz,
                      unsigned long flags, struct picotm_error* error)
 {
+    save_privatization(vmem_tx, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+
     while (siz) {
 
         /* released as part of apply() or undo() */
@@ -538,6 +901,11 @@ tm_vmem_tx_privatize_c(struct tm_vmem_tx* vmem_tx, uintptr_t addr, int c,
 {
     bool found_c = false;
 
+    save_privatization(vmem_tx, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+
     while (!found_c) {
 
         /* released as part of apply() or undo() */
@@ -584,6 +952,7 @@ apply_page_cb(struct picotm_slist* item, void* data1, void* data2)
 void
 tm_vmem_tx_apply(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
 {
+    sort_active_pages(vmem_tx);
     picotm_slist_walk_2(&vmem_tx->active_pages, apply_page_cb,
                         vmem_tx->vmem, error);
 }
@@ -612,6 +981,7 @@ undo_page_cb(struct picotm_slist* item, void* data1, void* data2)
 void
 tm_vmem_tx_undo(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
 {
+    sort_active_pages(vmem_tx);
     picotm_slist_walk_2(&vmem_tx->active_pages, undo_page_cb,
                         vmem_tx->vmem, error);
 }
@@ -627,8 +997,8 @@ finish_page(struct tm_page* page, struct tm_vmem_tx* vmem_tx,
         }
     }
 
+    picotm_slist_uninit_item(&page->list);
     tm_page_uninit(page);
-    free_page(vmem_tx, page);
 }
 
 static void
@@ -642,4 +1012,14 @@ tm_vmem_tx_finish(struct tm_vmem_tx* vmem_tx, struct picotm_error* error)
 {
     picotm_slist_cleanup_2(&vmem_tx->active_pages, finish_page_cb, vmem_tx,
                            error);
+
+    tm_vmem_end_tx(vmem_tx->vmem, &vmem_tx->reader);
+
+    free_all_pages(vmem_tx);
+    clear_pagetab(vmem_tx);
+    vmem_tx->active_pages_is_sorted = true;
+
+    vmem_tx->savetablen = 0;
+    vmem_tx->savepoint = 0;
+    vmem_tx->nsavepoints = 0;
 }
@@ -23,6 +23,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include "block.h"
+#include "framemap.h"
 
 /**
  * \cond impl || tm_impl
@@ -33,9 +35,20 @@
 
 struct picotm_error;
 struct tm_page;
+struct tm_page_slab;
 struct tm_vmem;
 struct tm_vmem_tx;
 
+/**
+ * |struct tm_page_save| holds a page's content at a savepoint. An
+ * entry without page marks privatized memory, which cannot be restored.
+ */
+struct tm_page_save {
+    struct tm_page* page;
+    uint8_t buf[TM_BLOCK_SIZE];
+    tm_block_bitmap buf_bits;
+};
+
 /**
  * |struct tm_vmem_tx| represents a memory transaction.
  */
@@ -46,9 +59,26 @@ struct tm_vmem_tx {
     /* module index */
     unsigned long module;
 
+    /* announces the transaction's frame look-ups */
+    struct tm_frame_map_reader reader;
+
     /* page-allocator fields */
     struct picotm_slist active_pages;
-    struct picotm_slist alloced_pages;
+    struct tm_page_slab* slabs;
+    struct tm_page_slab* slab;
+    size_t slab_npages;
+    size_t nslabs;
+    /* page-index fields */
+    struct tm_page** pagetab;
+    unsigned int pagetabbits;
+    size_t npages;
+    bool active_pages_is_sorted;
+    /* savepoint fields */
+    struct tm_page_save* savetab;
+    size_t savetablen;
+    size_t savetabsiz;
+    unsigned long savepoint;    /* increases with each savepoint */
+    unsigned long nsavepoints;  /* number of active savepoints */
 };
 
 /**
@@ -99,6 +129,26 @@ void
 tm_vmem_tx_privatize_c(struct tm_vmem_tx* vmem_tx, uintptr_t addr, int c,
                        unsigned long flags, struct picotm_error* error);
 
+/**
+ * Sets a savepoint for a nested transaction.
+ * \returns The mark of the savepoint.
+ */
+uintptr_t
+tm_vmem_tx_savepoint(struct tm_vmem_tx* vmem_tx);
+
+/**
+ * Reverts all transaction-local changes since a savepoint.
+ */
+void
+tm_vmem_tx_rollback_to_savepoint(struct tm_vmem_tx* vmem_tx, uintptr_t mark,
+                                 struct picotm_error* error);
+
+/**
+ * Releases a savepoint after its nested transaction committed.
+ */
+void
+tm_vmem_tx_release_savepoint(struct tm_vmem_tx* vmem_tx, uintptr_t mark);
+
 /**
  * Applies all transaction-local changes to main memory.
  */
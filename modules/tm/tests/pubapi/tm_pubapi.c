@@ -21,12 +21,14 @@
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-module.h"
 #include "picotm/picotm-lib-array.h"
+#include "picotm/picotm-tm.h"
 #include "picotm/picotm-tm-ctypes.h"
 #include <stdlib.h>
 #include <string.h>
 #include "ptr.h"
 #include "safeblk.h"
 #include "safe_stdio.h"
+#include "safe_stdlib.h"
 #include "taputils.h"
 #include "test.h"
 #include "testhlp.h"
@@ -746,6 +748,333 @@ tm_test_11(unsigned int tid)
     }
 }
 
+/**
+ * Load a shared value in a read-only transaction.
+ */
+static void
+tm_test_12(unsigned int tid)
+{
+    picotm_begin_readonly
+
+        unsigned long value = load_ulong_tx(&g_value);
+        if (!(value == g_value)) {
+            tap_error("condition failed: value == g_value");
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_error_set_error_code(&error, PICOTM_GENERAL_ERROR);
+            picotm_error_mark_as_non_recoverable(&error);
+            picotm_recover_from_error(&error);
+        }
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+}
+
+/**
+ * Store a value in a read-only transaction. Should generate a
+ * Read-Only error.
+ */
+static void
+tm_test_13(unsigned int tid)
+{
+    picotm_safe bool performed_error_recovery = false;
+
+    unsigned long value = 0;
+
+    picotm_begin_readonly
+
+        store_ulong_tx(&value, tid);
+
+    picotm_commit
+
+        if ((picotm_error_status() != PICOTM_ERROR_CODE) ||
+            (picotm_error_as_error_code() != PICOTM_READ_ONLY)) {
+            abort_transaction_on_error(__func__);
+        }
+
+        performed_error_recovery = true;
+        /* leave error recovery without restarting TX */
+
+    picotm_end
+
+    if (!performed_error_recovery) {
+        tap_error("Transaction did not perform error recovery.\n");
+        abort_safe_block();
+    }
+
+    if (!(value == 0)) {
+        tap_error("condition failed: value == 0");
+        abort_safe_block();
+    }
+}
+
+/**
+ * Retry a nested transaction after a conflict. The outer transaction
+ * should not restart.
+ */
+static void
+tm_test_14(unsigned int tid)
+{
+    picotm_safe unsigned long nouter = 0;
+    picotm_safe unsigned long ninner = 0;
+
+    unsigned long outer_value = 0;
+    unsigned long inner_value = 0;
+
+    picotm_begin
+
+        ++nouter;
+        store_ulong_tx(&outer_value, load_ulong_tx(&outer_value) + 1);
+
+        picotm_begin
+
+            ++ninner;
+            store_ulong_tx(&inner_value, load_ulong_tx(&inner_value) + 1);
+
+            if (ninner == 1) {
+                picotm_resolve_conflict(nullptr);
+            }
+
+        picotm_commit
+
+            abort_transaction_on_error(__func__);
+
+        picotm_end
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+
+    if (!(nouter == 1)) {
+        tap_error("condition failed: nouter == 1");
+        abort_safe_block();
+    }
+    if (!(ninner == 2)) {
+        tap_error("condition failed: ninner == 2");
+        abort_safe_block();
+    }
+    if (!(outer_value == 1)) {
+        tap_error("condition failed: outer_value == 1");
+        abort_safe_block();
+    }
+    if (!(inner_value == 1)) {
+        tap_error("condition failed: inner_value == 1");
+        abort_safe_block();
+    }
+}
+
+/**
+ * Retry a nested transaction after persisting conflicts. The outer
+ * transaction should restart eventually.
+ */
+static void
+tm_test_15(unsigned int tid)
+{
+    picotm_safe unsigned long nouter = 0;
+
+    unsigned long value = 0;
+
+    picotm_begin
+
+        ++nouter;
+
+        picotm_begin
+
+            store_ulong_tx(&value, load_ulong_tx(&value) + 1);
+
+            if (nouter == 1) {
+                picotm_resolve_conflict(nullptr);
+            }
+
+        picotm_commit
+
+            abort_transaction_on_error(__func__);
+
+        picotm_end
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+
+    if (!(nouter == 2)) {
+        tap_error("condition failed: nouter == 2");
+        abort_safe_block();
+    }
+    if (!(value == 1)) {
+        tap_error("condition failed: value == 1");
+        abort_safe_block();
+    }
+}
+
+/**
+ * Store and load a large buffer in reverse order. The transaction
+ * touches thousands of pages.
+ */
+static void
+tm_test_16(unsigned int tid)
+{
+    unsigned long buf[2048];
+    memset(buf, 0, sizeof(buf));
+
+    picotm_begin
+
+        for (size_t i = arraylen(buf); i; --i) {
+            store_ulong_tx(buf + i - 1, i - 1);
+        }
+        for (size_t i = arraylen(buf); i; --i) {
+            if (load_ulong_tx(buf + i - 1) != (i - 1)) {
+                tap_error("condition failed: load_ulong_tx(buf + i) == i");
+                abort_safe_block();
+            }
+        }
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+
+    for (size_t i = 0; i < arraylen(buf); ++i) {
+        if (!(buf[i] == i)) {
+            tap_error("condition failed: buf[i] == i");
+            abort_safe_block();
+        }
+    }
+}
+
+static const size_t tm_test_17_siz = 1ul << 20;
+
+/* Stores to a new buffer and returns the module's memory usage
+ * afterwards. The caller has to free the buffer. */
+static size_t
+tm_test_17_fill(unsigned long* buf)
+{
+    static const size_t stride = 256;
+
+    picotm_begin
+
+        for (size_t i = 0; i < tm_test_17_siz / sizeof(*buf); i += stride) {
+            store_ulong_tx(buf + i, i);
+        }
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+
+    return picotm_tm_get_memory_usage();
+}
+
+/* Runs an idle transaction. */
+static void
+tm_test_17_idle(unsigned long* value)
+{
+    picotm_begin
+
+        store_ulong_tx(value, load_ulong_tx(value) + 1);
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+}
+
+/**
+ * Release the state of memory regions that are not used any longer.
+ */
+static void
+tm_test_17(unsigned int tid)
+{
+    unsigned long* buf = safe_malloc(tm_test_17_siz);
+
+    size_t memory_usage = tm_test_17_fill(buf);
+
+    free(buf);
+
+    /* Idle transactions let the module reclaim the state of the
+     * released buffer. */
+
+    unsigned long value = 0;
+
+    for (unsigned long i = 0; i < (1ul << 20); ++i) {
+        if (picotm_tm_get_memory_usage() < memory_usage) {
+            return;
+        }
+        tm_test_17_idle(&value);
+    }
+
+    tap_error("condition failed: memory usage decreased");
+    abort_safe_block();
+}
+
+/**
+ * Retry a nested transaction after an earlier nested transaction
+ * committed. The outer transaction's stores in between should remain.
+ */
+static void
+tm_test_18(unsigned int tid)
+{
+    picotm_safe unsigned long ninner = 0;
+
+    unsigned long value[2] = {0, 0};
+
+    picotm_begin
+
+        picotm_begin
+
+            store_ulong_tx(value, load_ulong_tx(value) + 1);
+
+        picotm_commit
+
+            abort_transaction_on_error(__func__);
+
+        picotm_end
+
+        store_ulong_tx(value, load_ulong_tx(value) + 1);
+
+        picotm_begin
+
+            ++ninner;
+            store_ulong_tx(value + 1, load_ulong_tx(value) + 1);
+
+            if (ninner == 1) {
+                picotm_resolve_conflict(nullptr);
+            }
+
+        picotm_commit
+
+            abort_transaction_on_error(__func__);
+
+        picotm_end
+
+    picotm_commit
+
+        abort_transaction_on_error(__func__);
+
+    picotm_end
+
+    if (!(ninner == 2)) {
+        tap_error("condition failed: ninner == 2");
+        abort_safe_block();
+    }
+    if (!(value[0] == 2)) {
+        tap_error("condition failed: value[0] == 2");
+        abort_safe_block();
+    }
+    if (!(value[1] == 3)) {
+        tap_error("condition failed: value[1] == 3");
+        abort_safe_block();
+    }
+}
+
 static const struct test_func tm_test[] = {
     {"tm_test_1", tm_test_1, tm_test_1_pre, tm_test_1_post},
     {"tm_test_2", tm_test_2, tm_test_2_pre, tm_test_2_post},
@@ -757,7 +1086,16 @@ static const struct test_func tm_test[] = {
     {"tm_test_8", tm_test_8, nullptr, nullptr},
     {"Byte-wise load/store", tm_test_9, nullptr, nullptr},
     {"Byte-wise conditional-load/store", tm_test_10, nullptr, nullptr},
-    {"Byte-wise load/conditional-store", tm_test_11, nullptr, nullptr}
+    {"Byte-wise load/conditional-store", tm_test_11, nullptr, nullptr},
+    {"Read-only load", tm_test_12, nullptr, nullptr},
+    {"Read-only store", tm_test_13, nullptr, nullptr},
+    {"Nested transaction", tm_test_14, nullptr, nullptr},
+    {"Nested transaction with persisting conflicts", tm_test_15, nullptr,
+     nullptr},
+    {"Large transaction", tm_test_16, nullptr, nullptr},
+    {"Reclaim unused memory", tm_test_17, nullptr, nullptr},
+    {"Nested transaction after released savepoint", tm_test_18, nullptr,
+     nullptr}
 };
 
 /*
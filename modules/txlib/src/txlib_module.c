@@ -65,21 +65,23 @@ txlib_module_prepare_commit(struct txlib_module* self,
 }
 
 static void
-txlib_module_apply_event(struct txlib_module* self, uint16_t head,
-                         uintptr_t tail, struct picotm_error* error)
+txlib_module_apply_events(struct txlib_module* self,
+                          const struct picotm_event* event, size_t nevents,
+                          struct picotm_error* error)
 {
     assert(self);
 
-    txlib_tx_apply_event(&self->tx, head, tail, error);
+    txlib_tx_apply_events(&self->tx, event, nevents, error);
 }
 
 static void
-txlib_module_undo_event(struct txlib_module* self, uint16_t head,
-                        uintptr_t tail, struct picotm_error* error)
+txlib_module_undo_events(struct txlib_module* self,
+                         const struct picotm_event* event, size_t nevents,
+                         struct picotm_error* error)
 {
     assert(self);
 
-    txlib_tx_undo_event(&self->tx, head, tail, error);
+    txlib_tx_undo_events(&self->tx, event, nevents, error);
 }
 
 static void
@@ -106,19 +108,19 @@ prepare_commit_cb(void* data, int is_irrevocable, struct picotm_error* error)
 }
 
 static void
-apply_event_cb(uint16_t head, uintptr_t tail, void* data,
-               struct picotm_error* error)
+apply_events_cb(const struct picotm_event* event, size_t nevents,
+                void* data, struct picotm_error* error)
 {
     struct txlib_module* module = data;
-    txlib_module_apply_event(module, head, tail, error);
+    txlib_module_apply_events(module, event, nevents, error);
 }
 
 static void
-undo_event_cb(uint16_t head, uintptr_t tail, void* data,
-              struct picotm_error* error)
+undo_events_cb(const struct picotm_event* event, size_t nevents,
+               void* data, struct picotm_error* error)
 {
     struct txlib_module* module = data;
-    txlib_module_undo_event(module, head, tail, error);
+    txlib_module_undo_events(module, event, nevents, error);
 }
 
 static void
@@ -139,10 +141,10 @@ init_txlib_module(struct txlib_module* module, struct picotm_error* error)
 {
     static const struct picotm_module_ops s_ops = {
         .prepare_commit = prepare_commit_cb,
-        .apply_event = apply_event_cb,
-        .undo_event = undo_event_cb,
         .finish = finish_cb,
-        .release = release_cb
+        .release = release_cb,
+        .apply_events = apply_events_cb,
+        .undo_events = undo_events_cb
     };
 
     unsigned long module_id = picotm_register_module(&s_ops, module, error);
@@ -167,11 +169,20 @@ PICOTM_THREAD_STATE_STATIC_IMPL(txlib_module)
 static struct txlib_tx*
 get_txlib_tx(struct picotm_error* error)
 {
-    struct txlib_module* module = PICOTM_THREAD_STATE_ACQUIRE(txlib_module,
-                                                              true, error);
+    static __thread struct picotm_module_cache s_cache =
+        PICOTM_MODULE_CACHE_INITIALIZER;
+
+    struct txlib_module* module = picotm_module_cache_get(&s_cache);
+    if (module) {
+        return &module->tx;
+    }
+
+    module = PICOTM_THREAD_STATE_ACQUIRE(txlib_module, true, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
+    picotm_touch_module(module->tx.module);
+    picotm_module_cache_set(&s_cache, module);
     return &module->tx;
 }
 
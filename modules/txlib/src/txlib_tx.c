@@ -267,6 +267,26 @@ txlib_tx_acquire_txstack_of_state(struct txlib_tx* self,
     return &entry->data.stack_tx;
 }
 
+/* Events are initialized and appended to the transaction log in
+ * batches of this size. */
+#define TXLIB_TX_EVENT_BATCH_SIZE   (64)
+
+static void
+append_events(struct txlib_tx* self, size_t nevents, const uintptr_t tail[],
+              struct picotm_error* error)
+{
+    static const uint16_t head[TXLIB_TX_EVENT_BATCH_SIZE] = { 0, };
+
+    assert(nevents <= picotm_arraylen(head));
+
+    picotm_append_events(self->module, nevents, head, tail, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+
+    self->nevents += nevents;
+}
+
 void
 txlib_tx_append_events3(struct txlib_tx* self, size_t nevents,
                         void (*init)(struct txlib_event*, void*, void*, void*,
@@ -291,14 +311,29 @@ txlib_tx_append_events3(struct txlib_tx* self, size_t nevents,
     struct txlib_event* beg = picotm_arrayat(self->event, self->nevents);
     struct txlib_event* end = picotm_arrayat(self->event, newnevents);
 
-    for (; beg < end; ++beg, ++self->nevents) {
+    while (beg < end) {
 
-        init(beg, data1, data2, data3, error);
-        if (picotm_error_is_set(error)) {
-            return;
+        uintptr_t tail[TXLIB_TX_EVENT_BATCH_SIZE];
+        size_t ntail = 0;
+
+        for (; (beg < end) && (ntail < picotm_arraylen(tail)); ++beg) {
+
+            init(beg, data1, data2, data3, error);
+            if (picotm_error_is_set(error)) {
+                /* Log the initialized events, so that they will
+                 * be reverted during the roll-back. */
+                struct picotm_error append_error = PICOTM_ERROR_INITIALIZER;
+                append_events(self, ntail, tail, &append_error);
+                if (picotm_error_is_set(&append_error)) {
+                    picotm_error_mark_as_non_recoverable(error);
+                }
+                return;
+            }
+
+            tail[ntail++] = beg - self->event;
         }
 
-        picotm_append_event(self->module, 0, beg - self->event, error);
+        append_events(self, ntail, tail, error);
         if (picotm_error_is_set(error)) {
             return;
         }
@@ -418,28 +453,41 @@ txlib_tx_prepare_commit(struct txlib_tx* self, struct picotm_error* error)
 }
 
 void
-txlib_tx_apply_event(struct txlib_tx* self, unsigned short op,
-                     uintptr_t cookie, struct picotm_error* error)
+txlib_tx_apply_events(struct txlib_tx* self,
+                      const struct picotm_event* event, size_t nevents,
+                      struct picotm_error* error)
 {
     assert(self);
-    assert(cookie < self->nevents);
 
-    txlib_event_apply(self->event + cookie, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    const struct picotm_event* end = event + nevents;
+
+    for (; event < end; ++event) {
+        assert(event->tail < self->nevents);
+
+        txlib_event_apply(self->event + event->tail, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
     }
 }
 
 void
-txlib_tx_undo_event(struct txlib_tx* self, unsigned short op,
-                    uintptr_t cookie, struct picotm_error* error)
+txlib_tx_undo_events(struct txlib_tx* self,
+                     const struct picotm_event* event, size_t nevents,
+                     struct picotm_error* error)
 {
     assert(self);
-    assert(cookie < self->nevents);
 
-    txlib_event_undo(self->event + cookie, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    const struct picotm_event* pos = event + nevents;
+
+    while (event < pos) {
+        --pos;
+        assert(pos->tail < self->nevents);
+
+        txlib_event_undo(self->event + pos->tail, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
     }
 }
 
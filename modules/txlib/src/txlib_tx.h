@@ -36,6 +36,7 @@
  */
 
 struct picotm_error;
+struct picotm_event;
 struct txlib_event;
 
 struct txlib_tx_entry {
@@ -192,14 +193,14 @@ void
 txlib_tx_prepare_commit(struct txlib_tx* self, struct picotm_error* error);
 
 void
-txlib_tx_apply_event(struct txlib_tx* self,
-                     unsigned short op, uintptr_t cookie,
-                     struct picotm_error* error);
+txlib_tx_apply_events(struct txlib_tx* self,
+                      const struct picotm_event* event, size_t nevents,
+                      struct picotm_error* error);
 
 void
-txlib_tx_undo_event(struct txlib_tx* self,
-                    unsigned short op, uintptr_t cookie,
-                    struct picotm_error* error);
+txlib_tx_undo_events(struct txlib_tx* self,
+                     const struct picotm_event* event, size_t nevents,
+                     struct picotm_error* error);
 
 void
 txlib_tx_finish(struct txlib_tx* self);
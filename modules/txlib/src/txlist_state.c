@@ -18,10 +18,19 @@
  */
 
 #include "txlist_state.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
 #include <stddef.h>
+#include <stdio.h>
 #include "txlist_entry.h"
 
+static void
+describe_lock(const struct picotm_rwlock* lock, const void* data,
+              char* buf, size_t siz)
+{
+    snprintf(buf, siz, "txlist state %p", data);
+}
+
 PICOTM_EXPORT
 void
 txlist_state_init(struct txlist_state* self)
@@ -30,6 +39,9 @@ txlist_state_init(struct txlist_state* self)
 
     txlist_entry_init_head(&self->internal.head);
     picotm_rwlock_init(&self->internal.lock);
+    picotm_register_lock_range(&self->internal.lock,
+                               &self->internal.lock + 1,
+                               describe_lock, self);
 }
 
 PICOTM_EXPORT
@@ -38,6 +50,7 @@ txlist_state_uninit(struct txlist_state* self)
 {
     assert(self);
 
+    picotm_unregister_lock_range(&self->internal.lock);
     picotm_rwlock_uninit(&self->internal.lock);
     txlist_entry_uninit_head(&self->internal.head);
 }
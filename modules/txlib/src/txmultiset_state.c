@@ -18,10 +18,19 @@
  */
 
 #include "txmultiset_state.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
 #include <stddef.h>
+#include <stdio.h>
 #include "txmultiset_entry.h"
 
+static void
+describe_lock(const struct picotm_rwlock* lock, const void* data,
+              char* buf, size_t siz)
+{
+    snprintf(buf, siz, "txmultiset state %p", data);
+}
+
 PICOTM_EXPORT
 void
 txmultiset_state_init(struct txmultiset_state* self,
@@ -32,6 +41,9 @@ txmultiset_state_init(struct txmultiset_state* self,
 
     txmultiset_entry_init_head(&self->internal.head);
     picotm_rwlock_init(&self->internal.lock);
+    picotm_register_lock_range(&self->internal.lock,
+                               &self->internal.lock + 1,
+                               describe_lock, self);
     self->internal.key = key;
     self->internal.compare = compare;
 }
@@ -42,6 +54,7 @@ txmultiset_state_uninit(struct txmultiset_state* self)
 {
     assert(self);
 
+    picotm_unregister_lock_range(&self->internal.lock);
     picotm_rwlock_uninit(&self->internal.lock);
     txmultiset_entry_uninit_head(&self->internal.head);
 }
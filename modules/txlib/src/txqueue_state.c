@@ -18,9 +18,18 @@
  */
 
 #include "txqueue_state.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
+#include <stdio.h>
 #include "txqueue_entry.h"
 
+static void
+describe_lock(const struct picotm_rwlock* lock, const void* data,
+              char* buf, size_t siz)
+{
+    snprintf(buf, siz, "txqueue state %p", data);
+}
+
 PICOTM_EXPORT
 void
 txqueue_state_init(struct txqueue_state* self)
@@ -29,6 +38,9 @@ txqueue_state_init(struct txqueue_state* self)
 
     txqueue_entry_init_head(&self->internal.head);
     picotm_rwlock_init(&self->internal.lock);
+    picotm_register_lock_range(&self->internal.lock,
+                               &self->internal.lock + 1,
+                               describe_lock, self);
 }
 
 PICOTM_EXPORT
@@ -39,6 +51,7 @@ txqueue_state_uninit(struct txqueue_state* self)
     assert(txqueue_state_is_empty(self));
 
     txqueue_entry_uninit_head(&self->internal.head);
+    picotm_unregister_lock_range(&self->internal.lock);
     picotm_rwlock_uninit(&self->internal.lock);
 }
 
@@ -18,9 +18,18 @@
  */
 
 #include "txstack_state.h"
+#include "picotm/picotm-module.h"
 #include <assert.h>
+#include <stdio.h>
 #include "txstack_entry.h"
 
+static void
+describe_lock(const struct picotm_rwlock* lock, const void* data,
+              char* buf, size_t siz)
+{
+    snprintf(buf, siz, "txstack state %p", data);
+}
+
 PICOTM_EXPORT
 void
 txstack_state_init(struct txstack_state* self)
@@ -29,6 +38,9 @@ txstack_state_init(struct txstack_state* self)
 
     txstack_entry_init_head(&self->internal.head);
     picotm_rwlock_init(&self->internal.lock);
+    picotm_register_lock_range(&self->internal.lock,
+                               &self->internal.lock + 1,
+                               describe_lock, self);
 }
 
 PICOTM_EXPORT
@@ -39,6 +51,7 @@ txstack_state_uninit(struct txstack_state* self)
     assert(txstack_state_is_empty(self));
 
     txstack_entry_uninit_head(&self->internal.head);
+    picotm_unregister_lock_range(&self->internal.lock);
     picotm_rwlock_uninit(&self->internal.lock);
 }
 
@@ -19,25 +19,44 @@
 
 #include "picotm-lib-rwlock.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdint.h>
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-module.h"
 #include "picotm_lock_manager.h"
 #include "picotm_lock_owner.h"
 #include "picotm_os_timespec.h"
+#include "picotm_trace.h"
 
+#if defined(PICOTM_HAVE_WIDE_RWLOCK) && PICOTM_HAVE_WIDE_RWLOCK
+/** \brief The type of 'struct picotm_rwlock::n' */
+typedef uint_least32_t rwlock_bits;
 enum {
     /** \brief Offset of the waiter index in 'struct picotm_rwlock::n' */
-    INDEX_BIT_SHIFT = 4,
+    INDEX_BIT_SHIFT = 16
+};
+#else
+/** \brief The type of 'struct picotm_rwlock::n' */
+typedef uint_least8_t rwlock_bits;
+enum {
+    /** \brief Offset of the waiter index in 'struct picotm_rwlock::n' */
+    INDEX_BIT_SHIFT = 4
+};
+#endif
+
+enum {
     /** \brief Bitmask of the counter in 'struct picotm_rwlock::n' */
-    COUNTER_BIT_MASK = (1ul << INDEX_BIT_SHIFT) - 1
+    COUNTER_BIT_MASK = (1ul << INDEX_BIT_SHIFT) - 1,
+    /** \brief The largest waiter index in 'struct picotm_rwlock::n' */
+    MAX_INDEX = (1ul << (sizeof(rwlock_bits) * CHAR_BIT -
+                         INDEX_BIT_SHIFT)) - 1
 };
 
 /** \brief Bitmask of the waiter index in 'struct picotm_rwlock::n' */
-static const uint8_t INDEX_BIT_MASK = ~COUNTER_BIT_MASK;
+static const rwlock_bits INDEX_BIT_MASK = ~COUNTER_BIT_MASK;
 
 /** \brief Writer is present if this counter value is set. */
-static const uint8_t WRITER_COUNTER = COUNTER_BIT_MASK;
+static const rwlock_bits WRITER_COUNTER = COUNTER_BIT_MASK;
 
 PICOTM_EXPORT
 void
@@ -80,7 +99,7 @@ static const struct picotm_lock_slist_funcs s_picotm_rwlock_slist_funcs = {
     cmpxchg_first_index
 };
 
-static uint8_t
+static rwlock_bits
 rw_counter_bits(unsigned long value)
 {
     assert((value & COUNTER_BIT_MASK) == value);
@@ -89,86 +108,250 @@ rw_counter_bits(unsigned long value)
 }
 
 static unsigned long
-rw_counter(uint8_t n)
+rw_counter(rwlock_bits n)
 {
     return n & COUNTER_BIT_MASK;
 }
 
-static uint8_t
+static rwlock_bits
 rw_index_bits(unsigned long value)
 {
+    assert(value <= MAX_INDEX);
+
     return (value << INDEX_BIT_SHIFT) & INDEX_BIT_MASK;
 }
 
-static uint8_t
-rw_index(uint8_t n)
+static rwlock_bits
+rw_index(rwlock_bits n)
 {
     return (n & INDEX_BIT_MASK) >> INDEX_BIT_SHIFT;
 }
 
+/*
+ * Waiting
+ *
+ * A lock owner that fails to acquire a lock first asks the contention-
+ * management policy if it should wait at all. If so, it spins for a
+ * while, then sleeps for randomized, exponentially growing intervals,
+ * and finally parks in the lock manager. Otherwise it signals the
+ * conflict immediately. The number of spin iterations adapts to the
+ * outcome of the thread's recent spinning.
+ */
+
+enum {
+    /** \brief The minimum number of spin iterations */
+    MIN_NSPINS = 16,
+    /** \brief The maximum number of spin iterations */
+    MAX_NSPINS = 1024,
+    /** \brief The number of sleeping back-off rounds */
+    NBACKOFFS = 4
+};
+
+/** \brief The maximum sleeping time of the first back-off round */
+static const long BACKOFF_NSEC = 256;
+
 static void
-try_lock_or_wait(struct picotm_rwlock* self,
-                 bool (*try_lock)(struct picotm_rwlock*),
+cpu_relax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__ ("yield" ::: "memory");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+static bool
+spin(struct picotm_rwlock* self,
+     bool (*try_lock)(struct picotm_rwlock*, bool),
+     struct picotm_lock_owner_backoff* backoff)
+{
+    unsigned long nspins = 2 * backoff->nspins + MIN_NSPINS;
+    if (nspins > MAX_NSPINS) {
+        nspins = MAX_NSPINS;
+    }
+
+    for (unsigned long i = 0; i < nspins; ++i) {
+        cpu_relax();
+        if (try_lock(self, false)) {
+            /* Move the average towards the number of iterations
+             * we needed. */
+            backoff->nspins = backoff->nspins - backoff->nspins / 8 + i / 8;
+            return true;
+        }
+    }
+
+    /* Spinning didn't help; spin less next time. */
+    backoff->nspins -= backoff->nspins / 8;
+
+    return false;
+}
+
+static unsigned long
+random_nsec(struct picotm_lock_owner_backoff* backoff, unsigned long max_nsec)
+{
+    /* xorshift */
+    backoff->seed ^= backoff->seed << 13;
+    backoff->seed ^= backoff->seed >> 7;
+    backoff->seed ^= backoff->seed << 17;
+
+    return max_nsec / 2 + backoff->seed % (max_nsec / 2 + 1);
+}
+
+static bool
+sleep_and_retry(struct picotm_rwlock* self,
+                bool (*try_lock)(struct picotm_rwlock*, bool),
+                struct picotm_lock_owner_backoff* backoff,
+                struct picotm_error* error)
+{
+    for (unsigned int i = 0; i < NBACKOFFS; ++i) {
+
+        const struct timespec sleep_time = {
+            0, random_nsec(backoff, BACKOFF_NSEC << i)
+        };
+
+        picotm_os_nanosleep(&sleep_time, error);
+        if (picotm_error_is_set(error)) {
+            return false;
+        }
+        if (try_lock(self, false)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+park(struct picotm_rwlock* self, struct picotm_lock_owner* waiter,
+     struct picotm_error* error)
+{
+    struct picotm_lock_manager* lmanager =
+        picotm_lock_owner_get_lock_manager(waiter);
+
+    picotm_lock_manager_wait(lmanager, waiter, false,
+                             &s_picotm_rwlock_slist_funcs, self, error);
+}
+
+static void
+wait_prioritized(struct picotm_rwlock* self,
+                 bool (*try_lock)(struct picotm_rwlock*, bool),
+                 struct picotm_lock_owner* waiter,
                  struct picotm_error* error)
 {
     static const struct timespec sleep_time = {0, 50};
 
-    assert(try_lock);
+    /* The lock can only queue waiters with a small index. */
+    bool can_park = picotm_lock_owner_get_index(waiter) <= MAX_INDEX;
+
+    /* A prioritized lock owner never signals a conflict. It waits
+     * until all other lock owners released the lock. It ignores other
+     * waiters. */
+    while (!try_lock(self, true)) {
+        if (can_park) {
+            park(self, waiter, error);
+        } else {
+            picotm_os_nanosleep(&sleep_time, error);
+        }
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
 
-    struct picotm_lock_owner* waiter = nullptr;
+static void
+wait_for_lock(struct picotm_rwlock* self,
+              bool (*try_lock)(struct picotm_rwlock*, bool),
+              struct picotm_error* error)
+{
+    struct picotm_lock_owner* waiter =
+        picotm_lock_owner_get_thread_local_instance();
 
-    unsigned int nretries = 0;
+    if (picotm_lock_owner_is_prioritized(waiter)) {
+        wait_prioritized(self, try_lock, waiter, error);
+        return;
+    }
 
-    do {
+    struct picotm_lock_manager* lmanager =
+        picotm_lock_owner_get_lock_manager(waiter);
 
-        bool succ = try_lock(self);
+    if (!picotm_lock_manager_should_wait(lmanager, waiter)) {
+        /* The contention-management policy rather restarts the
+         * transaction than waiting for the lock. */
+        picotm_error_set_conflicting(error, self);
+        return;
+    }
 
-        if (succ) {
-            /* We successfully acquired the lock. */
-            return;
-        } else if (waiter) {
-            /* Neither an error nor success, but we already waited
-             * for the lock to become available. This time we signal
-             * a conflict to the caller. */
-            picotm_error_set_conflicting(error, self);
-            return;
-        } else {
+    struct picotm_lock_owner_backoff* backoff =
+        picotm_lock_owner_get_backoff(waiter);
 
-            if (nretries) {
-                picotm_os_nanosleep(&sleep_time, error);
-                if (picotm_error_is_set(error)) {
-                    return;
-                }
-                --nretries;
-                continue;
-            }
+    if (spin(self, try_lock, backoff)) {
+        return;
+    }
 
-            /* Neither an error nor success as the lock is currently
-             * blocked. We wait until the lock becomes available or
-             * a timeout fires. */
+    bool succ = sleep_and_retry(self, try_lock, backoff, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    } else if (succ) {
+        return;
+    }
 
-            assert(!waiter); /* We haven't waited already. */
+    if (picotm_lock_owner_get_index(waiter) > MAX_INDEX) {
+        /* The lock cannot store our index, so we cannot park. */
+        picotm_error_set_conflicting(error, self);
+        return;
+    }
 
-            waiter = picotm_lock_owner_get_thread_local_instance();
+    park(self, waiter, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
 
-            struct picotm_lock_manager* lmanager =
-                picotm_lock_owner_get_lock_manager(waiter);
+    if (try_lock(self, false)) {
+        return;
+    }
 
-            picotm_lock_manager_wait(lmanager, waiter, false,
-                                     &s_picotm_rwlock_slist_funcs, self,
-                                     error);
+    /* Neither an error nor success, but we already waited
+     * for the lock to become available. This time we signal
+     * a conflict to the caller. */
+    picotm_error_set_conflicting(error, self);
+}
 
-            if (picotm_error_is_set(error)) {
-                return;
-            }
+static void
+try_lock_or_wait(struct picotm_rwlock* self,
+                 bool (*try_lock)(struct picotm_rwlock*, bool),
+                 struct picotm_error* error)
+{
+    assert(try_lock);
+
+    if (try_lock(self, false)) {
+        /* We successfully acquired the lock. */
+        PICOTM_TRACE(PICOTM_TRACE_LOCK_ACQUIRE, self);
+        return;
+    }
+
+    /* Neither an error nor success as the lock is currently
+     * blocked. We wait until the lock becomes available or
+     * we give up. */
+
+    PICOTM_TRACE(PICOTM_TRACE_LOCK_BLOCKED, self);
+
+    wait_for_lock(self, try_lock, error);
+    if (picotm_error_is_set(error)) {
+        if (error->status == PICOTM_CONFLICTING) {
+            PICOTM_TRACE(PICOTM_TRACE_LOCK_CONFLICT, self);
         }
-    } while (true);
+        return;
+    }
+
+    PICOTM_TRACE(PICOTM_TRACE_LOCK_ACQUIRE, self);
 }
 
 static bool
-try_rdlock(struct picotm_rwlock* self)
+try_rdlock(struct picotm_rwlock* self, bool ignore_waiters)
 {
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     do {
         if (rw_counter(n) == WRITER_COUNTER) {
@@ -177,13 +360,16 @@ try_rdlock(struct picotm_rwlock* self)
         } else if (rw_counter(n) == (unsigned long)(WRITER_COUNTER - 1)) {
             /* maximum number of readers reached; cannot read-lock */
             return false;
-        } else if (rw_index(n)) {
+        } else if (rw_index(n) && !ignore_waiters) {
             /* other transactions are already waiting; cannot read-lock */
             return false;
         }
 
-        uint8_t expected = rw_counter_bits(rw_counter(n));
-        uint8_t desired  = rw_counter_bits(rw_counter(n) + 1);
+        rwlock_bits index_bits = ignore_waiters
+                                    ? rw_index_bits(rw_index(n)) : 0;
+
+        rwlock_bits expected = index_bits | rw_counter_bits(rw_counter(n));
+        rwlock_bits desired  = index_bits | rw_counter_bits(rw_counter(n) + 1);
 
         bool succ = atomic_compare_exchange_strong_explicit(&self->n,
                                                             &expected, desired,
@@ -207,25 +393,28 @@ picotm_rwlock_try_rdlock(struct picotm_rwlock* self,
 }
 
 static bool
-try_wrlock(struct picotm_rwlock* self)
+try_wrlock(struct picotm_rwlock* self, bool ignore_waiters)
 {
     assert(self);
 
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     do {
 
         if (rw_counter(n)) {
             /* other transactions present; cannot write-lock */
             return false;
-        } else if (rw_index(n)) {
+        } else if (rw_index(n) && !ignore_waiters) {
             /* other waiters are already present; cannot write-lock */
             return false;
         }
 
+        rwlock_bits index_bits = ignore_waiters
+                                    ? rw_index_bits(rw_index(n)) : 0;
+
         /* Expect us to be the only transaction. */
-        uint8_t expected = rw_counter_bits(0);
-        uint8_t desired  = rw_counter_bits(WRITER_COUNTER);
+        rwlock_bits expected = index_bits | rw_counter_bits(0);
+        rwlock_bits desired  = index_bits | rw_counter_bits(WRITER_COUNTER);
 
         bool succ = atomic_compare_exchange_strong_explicit(&self->n,
                                                             &expected, desired,
@@ -241,11 +430,11 @@ try_wrlock(struct picotm_rwlock* self)
 }
 
 static bool
-try_uplock(struct picotm_rwlock* self)
+try_uplock(struct picotm_rwlock* self, bool ignore_waiters)
 {
     assert(self);
 
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     do {
 
@@ -260,11 +449,11 @@ try_uplock(struct picotm_rwlock* self)
          * transactions can be ignored as we already hold the lock in
          * reader mode. */
 
-        uint8_t expected = rw_index_bits(rw_index(n)) |
-                           rw_counter_bits(1);
+        rwlock_bits expected = rw_index_bits(rw_index(n)) |
+                               rw_counter_bits(1);
 
-        uint8_t desired = rw_index_bits(rw_index(n)) |
-                          rw_counter_bits(WRITER_COUNTER);
+        rwlock_bits desired = rw_index_bits(rw_index(n)) |
+                              rw_counter_bits(WRITER_COUNTER);
 
         bool succ =
             atomic_compare_exchange_strong_explicit(&self->n,
@@ -291,11 +480,20 @@ void
 picotm_rwlock_try_wrlock(struct picotm_rwlock* self, bool upgrade,
                          struct picotm_error* error)
 {
-    static bool (* const try_lock[])(struct picotm_rwlock*) = {
+    static bool (* const try_lock[])(struct picotm_rwlock*, bool) = {
         try_wrlock,
         try_uplock
     };
 
+    /* Read-only transactions fail before they acquire any writer
+     * lock. They never have to undo a modification. */
+    struct picotm_lock_owner* lo =
+        picotm_lock_owner_get_thread_local_instance();
+    if (picotm_lock_owner_is_readonly(lo)) {
+        picotm_error_set_error_code(error, PICOTM_READ_ONLY);
+        return;
+    }
+
     try_lock_or_wait(self, try_lock[upgrade], error);
 }
 
@@ -305,7 +503,7 @@ picotm_rwlock_unlock(struct picotm_rwlock* self)
 {
     assert(self);
 
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     assert(rw_counter(n) != 0);
 
@@ -373,7 +571,7 @@ picotm_rwlock_get_index(struct picotm_rwlock* self)
 {
     assert(self);
 
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     return rw_index(n);
 }
@@ -385,23 +583,23 @@ picotm_rwlock_cmpxchg_index(struct picotm_rwlock* self,
 {
     assert(self);
 
-    uint8_t n = atomic_load_explicit(&self->n, memory_order_acquire);
+    rwlock_bits n = atomic_load_explicit(&self->n, memory_order_acquire);
 
     do {
         /* Test and ... */
 
-        uint8_t current_index = rw_index(n);
+        rwlock_bits current_index = rw_index(n);
         if (current_index != expected_index) {
             return current_index;
         }
 
         /* ... Test-And-Set. */
 
-        uint8_t expected = rw_counter_bits(rw_counter(n)) |
-                           rw_index_bits(expected_index);
+        rwlock_bits expected = rw_counter_bits(rw_counter(n)) |
+                               rw_index_bits(expected_index);
 
-        uint8_t desired = rw_counter_bits(rw_counter(n)) |
-                          rw_index_bits(desired_index);
+        rwlock_bits desired = rw_counter_bits(rw_counter(n)) |
+                              rw_index_bits(desired_index);
 
         bool succ =
             atomic_compare_exchange_strong_explicit(&self->n,
@@ -345,3 +345,86 @@ picotm_shared_treemap_find_value(
 
     return entry;
 }
+
+PICOTM_EXPORT
+bool
+picotm_shared_treemap_remove_value(struct picotm_shared_treemap* self,
+                                   unsigned long long key, uintptr_t value)
+{
+    assert(self);
+    assert(value);
+
+    struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+
+    atomic_uintptr_t* entry_ptr = lookup_value_entry(&self->root, self->depth,
+                                                     key, false,
+                                                     self->level_nbits,
+                                                     &error);
+    if (!entry_ptr) {
+        return false; /* no directory, no value */
+    }
+
+    return atomic_compare_exchange_strong_explicit(entry_ptr, &value, 0,
+                                                   memory_order_acq_rel,
+                                                   memory_order_relaxed);
+}
+
+static void
+recursive_walk_dir(
+    struct shared_treemap_dir* dir, unsigned long depth,
+    unsigned long long key, unsigned long level_nbits,
+    struct picotm_shared_treemap* treemap, void* data,
+    picotm_shared_treemap_value_call_function value_call,
+    struct picotm_error* error)
+{
+    assert(dir);
+    assert(depth);
+    assert(value_call);
+
+    --depth;
+
+    for (unsigned long i = 0; i < level_nentries(level_nbits); ++i) {
+
+        uintptr_t entry = atomic_load_explicit(dir->entry + i,
+                                               memory_order_acquire);
+        if (!entry) {
+            continue;
+        }
+
+        unsigned long long entry_key = (key << level_nbits) | i;
+
+        if (depth) {
+            recursive_walk_dir((struct shared_treemap_dir*)entry, depth,
+                               entry_key, level_nbits, treemap, data,
+                               value_call, error);
+        } else {
+            value_call(entry, entry_key, treemap, data, error);
+        }
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
+PICOTM_EXPORT
+void
+picotm_shared_treemap_for_each_value(
+    struct picotm_shared_treemap* self, void* data,
+    picotm_shared_treemap_value_call_function value_call,
+    struct picotm_error* error)
+{
+    assert(self);
+    assert(value_call);
+
+    uintptr_t root = atomic_load_explicit(&self->root, memory_order_acquire);
+    if (!root) {
+        return;
+    }
+
+    if (self->depth) {
+        recursive_walk_dir((struct shared_treemap_dir*)root, self->depth, 0,
+                           self->level_nbits, self, data, value_call, error);
+    } else {
+        value_call(root, 0, self, data, error);
+    }
+}
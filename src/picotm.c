@@ -28,7 +28,11 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "picotm_contention.h"
 #include "picotm_lock_manager.h"
+#include "picotm_profiler.h"
+#include "picotm_stats.h"
+#include "picotm_trace.h"
 #include "picotm_tx.h"
 
 /*
@@ -127,9 +131,22 @@ PICOTM_STATE_STATIC_IMPL(thread_state, struct thread_state,
 
 PICOTM_THREAD_STATE_STATIC_IMPL(thread_state)
 
+/**
+ * The thread's transaction. It's set after the thread state has been
+ * acquired and cleared by picotm_release(). Most calls only read this
+ * pointer instead of acquiring the thread state.
+ */
+static __thread struct picotm_tx* t_tx;
+
+PICOTM_EXPORT
+__thread unsigned long __picotm_tx_number;
+
 static struct picotm_tx*
 get_tx(bool initialize, struct picotm_error* error)
 {
+    if (t_tx) {
+        return t_tx;
+    }
     struct thread_state* thread = PICOTM_THREAD_STATE_ACQUIRE(thread_state,
                                                               initialize,
                                                               error);
@@ -138,7 +155,8 @@ get_tx(bool initialize, struct picotm_error* error)
     } else if (!thread) {
         return nullptr; /* not yet initialized */
     }
-    return &thread->tx;
+    t_tx = &thread->tx;
+    return t_tx;
 }
 
 static struct picotm_tx*
@@ -196,19 +214,77 @@ picotm_lock_owner_get_lock_manager(struct picotm_lock_owner* lo)
     return tx->lm;
 }
 
+struct picotm_tx_stats*
+picotm_lock_owner_get_tx_stats(struct picotm_lock_owner* lo)
+{
+    assert(lo);
+
+    struct picotm_tx* tx = picotm_containerof(lo, struct picotm_tx, lo);
+
+    return &tx->stats;
+}
+
 /*
  * Public interface
  */
 
-PICOTM_EXPORT
-_Bool
-__picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env)
+static void
+restart_tx(struct picotm_tx* tx, enum __picotm_mode mode)
+{
+    assert(tx);
+
+    /* Restarting the transaction here transfers control
+     * to __picotm_begin(). */
+    __picotm_longjmp(*(tx->env), (int)mode);
+}
+
+static void
+restart_tx_from_conflict(struct picotm_tx* tx)
+{
+    assert(tx);
+
+    if (picotm_tx_can_rollback_to_savepoint(tx)) {
+        /* Retrying the innermost nested transaction with a
+         * savepoint transfers control to its __picotm_begin(). */
+        const struct picotm_savepoint* savepoint =
+            tx->savepoint + tx->nsavepoints - 1;
+        __picotm_longjmp(*(savepoint->env), PICOTM_MODE_RETRY_NESTED);
+    }
+    restart_tx(tx, PICOTM_MODE_RETRY);
+}
+
+static void
+restart_tx_from_error(struct picotm_tx* tx, const struct picotm_error* error)
+{
+    assert(error);
+    assert(picotm_error_is_set(error));
+
+    switch (error->status) {
+    case PICOTM_CONFLICTING:
+        restart_tx_from_conflict(tx);
+        break;
+    case PICOTM_REVOCABLE:
+        restart_tx(tx, PICOTM_MODE_IRREVOCABLE);
+        break;
+    case PICOTM_ERROR_CODE:     /* fall through */
+    case PICOTM_ERRNO:          /* fall through */
+    case PICOTM_KERN_RETURN_T:  /* fall through */
+    case PICOTM_SIGINFO_T:
+        restart_tx(tx, PICOTM_MODE_RECOVERY);
+        break;
+    }
+}
+
+static bool
+begin_tx(enum __picotm_mode mode, __picotm_jmp_buf* env, bool is_readonly,
+         const void* call_site)
 {
     static const unsigned char tx_mode[] = {
         TX_MODE_REVOCABLE,
         TX_MODE_REVOCABLE,
         TX_MODE_IRREVOCABLE,
         TX_MODE_REVOCABLE,
+        TX_MODE_REVOCABLE,
         TX_MODE_REVOCABLE
     };
 
@@ -219,18 +295,51 @@ __picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env)
         if (picotm_error_is_set(&error)) {
             return false; /* Enter recovery mode. */
         }
+        picotm_tx_stats_add_abort(&tx->stats, picotm_error_status());
         if (!picotm_error_is_non_recoverable()) {
             picotm_tx_rollback(tx, &error);
+        } else {
+            /* Changes cannot be reverted after non-recoverable
+             * errors, but the next transaction has to start
+             * from a clean state. */
+            picotm_tx_abort(tx);
         }
         /* We're recovering from an error. Returning 'false'
          * will invoke the transaction's recovery code. */
         return false;
     }
+    case PICOTM_MODE_RETRY_NESTED: {
+            /* We retry a nested transaction. Clear the old error state. */
+            struct picotm_error* error = get_non_null_error();
+            if (picotm_profiler_is_enabled()) {
+                picotm_profiler_add_conflict(error->value.conflicting_lock);
+            }
+            memset(error, 0, sizeof(*error));
+
+            struct picotm_tx* tx = get_non_null_tx();
+            picotm_tx_stats_add_abort(&tx->stats, PICOTM_CONFLICTING);
+
+            picotm_tx_rollback_to_savepoint(tx, error);
+            if (picotm_error_is_set(error)) {
+                /* Restarting the outermost transaction rolls back
+                 * the remaining changes. */
+                if ((error->status != PICOTM_CONFLICTING) ||
+                    error->is_non_recoverable) {
+                    restart_tx(tx, PICOTM_MODE_RECOVERY);
+                }
+                restart_tx(tx, PICOTM_MODE_RETRY);
+            }
+        }
+        return true;
     case PICOTM_MODE_IRREVOCABLE:
         /* fall through */
     case PICOTM_MODE_RETRY: {
             /* We (re-)start a transaction. Clear the old error state. */
             struct picotm_error* error = get_non_null_error();
+            if ((error->status == PICOTM_CONFLICTING) &&
+                picotm_profiler_is_enabled()) {
+                picotm_profiler_add_conflict(error->value.conflicting_lock);
+            }
             memset(error, 0, sizeof(*error));
 
             struct picotm_tx* tx = get_tx(false, error);
@@ -257,7 +366,36 @@ __picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env)
                 return false; /* Enter recovery mode. */
             }
 
-            picotm_tx_begin(tx, tx_mode[mode], mode != PICOTM_MODE_START, env, error);
+            if ((mode == PICOTM_MODE_START) && picotm_tx_is_active(tx)) {
+                /* Errors in nested transactions are handled by
+                 * the outermost transaction. */
+                picotm_tx_begin_nested(tx, env, error);
+                if (picotm_error_is_set(error)) {
+                    restart_tx_from_error(tx, error);
+                }
+                return true;
+            }
+
+            switch (mode) {
+            case PICOTM_MODE_RETRY:
+                picotm_tx_stats_add_abort(&tx->stats, PICOTM_CONFLICTING);
+                break;
+            case PICOTM_MODE_IRREVOCABLE:
+                picotm_tx_stats_add_abort(&tx->stats, PICOTM_REVOCABLE);
+                break;
+            case PICOTM_MODE_RESTART:
+                picotm_tx_stats_add_restart(&tx->stats);
+                break;
+            default:
+                break;
+            }
+
+            /* Invalidates all module caches of the thread. */
+            ++__picotm_tx_number;
+
+            picotm_tx_begin(tx, tx_mode[mode], is_readonly,
+                            mode != PICOTM_MODE_START, env, call_site,
+                            error);
             if (picotm_error_is_set(error)) {
                 return false; /* Enter recovery mode. */
             }
@@ -266,36 +404,28 @@ __picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env)
     return true;
 }
 
-static void
-restart_tx(struct picotm_tx* tx, enum __picotm_mode mode)
-{
-    assert(tx);
+/* The return address identifies the transaction's call site
+ * in the program. Adaptive retrying and escalation is done per
+ * call site. The jump buffer lives on the stack and its address
+ * is not stable across calls. */
+#if defined(__GNUC__)
+#define CALL_SITE()     __builtin_return_address(0)
+#else
+#define CALL_SITE()     nullptr
+#endif
 
-    /* Restarting the transaction here transfers control
-     * to __picotm_begin(). */
-    __picotm_longjmp(*(tx->env), (int)mode);
+PICOTM_EXPORT
+_Bool
+__picotm_begin(enum __picotm_mode mode, __picotm_jmp_buf* env)
+{
+    return begin_tx(mode, env, false, CALL_SITE());
 }
 
-static void
-restart_tx_from_error(struct picotm_tx* tx, const struct picotm_error* error)
+PICOTM_EXPORT
+_Bool
+__picotm_begin_readonly(enum __picotm_mode mode, __picotm_jmp_buf* env)
 {
-    assert(error);
-    assert(picotm_error_is_set(error));
-
-    switch (error->status) {
-    case PICOTM_CONFLICTING:
-        restart_tx(tx, PICOTM_MODE_RETRY);
-        break;
-    case PICOTM_REVOCABLE:
-        restart_tx(tx, PICOTM_MODE_IRREVOCABLE);
-        break;
-    case PICOTM_ERROR_CODE:     /* fall through */
-    case PICOTM_ERRNO:          /* fall through */
-    case PICOTM_KERN_RETURN_T:  /* fall through */
-    case PICOTM_SIGINFO_T:
-        restart_tx(tx, PICOTM_MODE_RECOVERY);
-        break;
-    }
+    return begin_tx(mode, env, true, CALL_SITE());
 }
 
 PICOTM_EXPORT
@@ -322,7 +452,14 @@ PICOTM_EXPORT
 void
 picotm_irrevocable()
 {
-    restart_tx(get_non_null_tx(), PICOTM_MODE_IRREVOCABLE);
+    struct picotm_tx* tx = get_non_null_tx();
+
+    /* Transactions can start in irrevocable mode. Restarting
+     * them would not change their mode. */
+    if (picotm_tx_is_irrevocable(tx)) {
+        return;
+    }
+    restart_tx(tx, PICOTM_MODE_IRREVOCABLE);
 }
 
 PICOTM_EXPORT
@@ -347,11 +484,64 @@ picotm_number_of_restarts()
     return tx->nretries;
 }
 
+PICOTM_EXPORT
+void
+picotm_set_contention_policy(enum picotm_contention_policy policy)
+{
+    picotm_contention_set_policy(policy);
+}
+
+PICOTM_EXPORT
+enum picotm_contention_policy
+picotm_get_contention_policy()
+{
+    return picotm_contention_get_policy();
+}
+
+PICOTM_EXPORT
+void
+picotm_get_stats(struct picotm_stats* stats)
+{
+    picotm_stats_get(stats);
+}
+
+PICOTM_EXPORT
+void
+picotm_set_conflict_profiling(_Bool enabled)
+{
+    picotm_profiler_set_enabled(enabled);
+}
+
+PICOTM_EXPORT
+size_t
+picotm_get_conflict_hotspots(struct picotm_conflict_hotspot* hotspot,
+                             size_t n)
+{
+    return picotm_profiler_get_hotspots(hotspot, n);
+}
+
+PICOTM_EXPORT
+void
+picotm_print_conflict_hotspots(FILE* stream, size_t n)
+{
+    picotm_profiler_print_hotspots(stream, n);
+}
+
+PICOTM_EXPORT
+void
+picotm_flush_trace()
+{
+    picotm_trace_flush();
+}
+
 PICOTM_EXPORT
 void
 picotm_release()
 {
+    t_tx = nullptr;
+    ++__picotm_tx_number;
     PICOTM_THREAD_STATE_RELEASE(thread_state);
+    picotm_trace_release();
 }
 
 PICOTM_EXPORT
@@ -412,6 +602,13 @@ picotm_register_module(const struct picotm_module_ops* ops, void* data,
     return picotm_tx_register_module(get_non_null_tx(), ops, data, error);
 }
 
+PICOTM_EXPORT
+void
+picotm_touch_module(unsigned long module)
+{
+    picotm_tx_touch_module(get_non_null_tx(), module);
+}
+
 PICOTM_EXPORT
 void
 picotm_append_event(unsigned long module, uint16_t head, uintptr_t tail,
@@ -420,13 +617,39 @@ picotm_append_event(unsigned long module, uint16_t head, uintptr_t tail,
     picotm_tx_append_event(get_non_null_tx(), module, head, tail, error);
 }
 
+PICOTM_EXPORT
+void
+picotm_append_events(unsigned long module, size_t nevents,
+                     const uint16_t head[], const uintptr_t tail[],
+                     struct picotm_error* error)
+{
+    picotm_tx_append_events(get_non_null_tx(), module, nevents, head, tail,
+                            error);
+}
+
+PICOTM_EXPORT
+void
+picotm_register_lock_range(const void* beg, const void* end,
+                           picotm_describe_lock_function describe,
+                           const void* data)
+{
+    picotm_profiler_register_locks(beg, end, describe, data);
+}
+
+PICOTM_EXPORT
+void
+picotm_unregister_lock_range(const void* beg)
+{
+    picotm_profiler_unregister_locks(beg);
+}
+
 PICOTM_EXPORT
 void
 picotm_resolve_conflict(struct picotm_rwlock* conflicting_lock)
 {
     picotm_error_set_conflicting(get_non_null_error(), conflicting_lock);
 
-    restart_tx(get_non_null_tx(), PICOTM_MODE_RETRY);
+    restart_tx_from_conflict(get_non_null_tx());
 }
 
 PICOTM_EXPORT
@@ -0,0 +1,91 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "picotm_contention.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "picotm/picotm-lib-array.h"
+
+/** \brief The policy has not been set yet. */
+#define POLICY_UNSET    (-1)
+
+static atomic_int s_policy = POLICY_UNSET;
+
+static enum picotm_contention_policy
+policy_from_env(void)
+{
+    static const char* const s_policy_name[] = {
+        [PICOTM_CONTENTION_POLICY_GREEDY] = "greedy",
+        [PICOTM_CONTENTION_POLICY_KARMA] = "karma",
+        [PICOTM_CONTENTION_POLICY_POLKA] = "polka",
+        [PICOTM_CONTENTION_POLICY_PASSIVE] = "passive",
+        [PICOTM_CONTENTION_POLICY_AGGRESSIVE] = "aggressive"
+    };
+
+    const char* value = getenv("PICOTM_CONTENTION_POLICY");
+    if (!value) {
+        return PICOTM_CONTENTION_POLICY_GREEDY;
+    }
+
+    for (size_t i = 0; i < picotm_arraylen(s_policy_name); ++i) {
+        if (!strcmp(value, s_policy_name[i])) {
+            return i;
+        }
+    }
+
+    /* Unknown policies select the default. */
+    return PICOTM_CONTENTION_POLICY_GREEDY;
+}
+
+enum picotm_contention_policy
+picotm_contention_get_policy()
+{
+    int policy = atomic_load_explicit(&s_policy, memory_order_acquire);
+    if (policy != POLICY_UNSET) {
+        return policy;
+    }
+
+    /* A concurrent call to picotm_contention_set_policy() takes
+     * precedence over the environment. */
+    int expected = POLICY_UNSET;
+    int desired = policy_from_env();
+
+    bool succ = atomic_compare_exchange_strong_explicit(&s_policy,
+                                                        &expected, desired,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire);
+    if (succ) {
+        return desired;
+    }
+    return expected;
+}
+
+void
+picotm_contention_set_policy(enum picotm_contention_policy policy)
+{
+    /* Invalid policies would select a non-existing set of call-backs
+     * on the next conflict; ignore them. */
+    if ((unsigned int)policy > PICOTM_CONTENTION_POLICY_AGGRESSIVE) {
+        return;
+    }
+
+    atomic_store_explicit(&s_policy, policy, memory_order_release);
+}
@@ -0,0 +1,48 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "picotm/picotm.h"
+
+/**
+ * \cond impl || lib_impl
+ * \ingroup lib_impl
+ * \file
+ * \endcond
+ */
+
+/**
+ * \brief Returns the process-wide contention-management policy.
+ * \returns The current contention-management policy.
+ *
+ * Unless the policy has been set before, the first call reads the
+ * policy from the environment variable `PICOTM_CONTENTION_POLICY`.
+ */
+enum picotm_contention_policy
+picotm_contention_get_policy(void);
+
+/**
+ * \brief Sets the process-wide contention-management policy.
+ * \param policy The new contention-management policy.
+ *
+ * Invalid policies are ignored.
+ */
+void
+picotm_contention_set_policy(enum picotm_contention_policy policy);
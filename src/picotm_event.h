@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "picotm/picotm-module.h"
 #include <stdint.h>
 
 /**
@@ -30,21 +31,6 @@
 
 struct picotm_error;
 
-/**
- * \brief Represents an event in a transaction's event log.
- */
-struct picotm_event {
-    /** \brief The module id. */
-    uint16_t module;
-    /** \brief The event's head data field. */
-    uint16_t head;
-
-    /* Possibly padding bytes here */
-
-    /** \brief A pointer to the event's tail data, or the tail data itself. */
-    uintptr_t tail;
-};
-
 /**
  * Static initializer for `struct picotm_event`.
  * \param   _module The instance's module value.
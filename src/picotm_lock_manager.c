@@ -19,10 +19,11 @@
 
 #include "picotm_lock_manager.h"
 #include <assert.h>
-#include <search.h>
-#include <string.h>
+#include "picotm_contention.h"
 #include "picotm_lock_owner.h"
 #include "picotm_os_timespec.h"
+#include "picotm_stats.h"
+#include "picotm_trace.h"
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
 #include "picotm/picotm-module.h"
@@ -39,8 +40,12 @@ picotm_lock_manager_init(struct picotm_lock_manager* self,
         return;
     }
 
-    self->lo = nullptr;
+    for (size_t i = 0; i < picotm_arraylen(self->lo); ++i) {
+        self->lo[i] = nullptr;
+    }
     self->nlos = 0;
+    self->free_lo = nullptr;
+    self->nfree_los = 0;
 
     picotm_os_rwlock_init(&self->exclusive_lo_lock, error);
     if (picotm_error_is_set(error)) {
@@ -48,9 +53,17 @@ picotm_lock_manager_init(struct picotm_lock_manager* self,
     }
 
     self->exclusive_lo = nullptr;
+    atomic_init(&self->has_exclusive_lo, false);
+
+    picotm_os_mutex_init(&self->prioritized_lo_mutex, error);
+    if (picotm_error_is_set(error)) {
+        goto err_picotm_os_mutex_init;
+    }
 
     return;
 
+err_picotm_os_mutex_init:
+    picotm_os_rwlock_uninit(&self->exclusive_lo_lock);
 err_picotm_os_rwlock_init:
     picotm_os_rwlock_uninit(&self->lo_rwlock);
 }
@@ -60,12 +73,25 @@ picotm_lock_manager_uninit(struct picotm_lock_manager* self)
 {
     assert(self);
 
-    tabfree(self->lo);
+    for (size_t i = 0; i < picotm_arraylen(self->lo); ++i) {
+        tabfree(self->lo[i]);
+    }
+    tabfree(self->free_lo);
 
+    picotm_os_mutex_uninit(&self->prioritized_lo_mutex);
     picotm_os_rwlock_uninit(&self->exclusive_lo_lock);
     picotm_os_rwlock_uninit(&self->lo_rwlock);
 }
 
+static struct picotm_lock_owner**
+lo_at(struct picotm_lock_manager* self, unsigned long index)
+{
+    assert(index < self->nlos);
+
+    return self->lo[index / PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES] +
+           index % PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES;
+}
+
 /*
  * Requires writer lock on lock_manager::lo_rwlock
  */
@@ -74,71 +100,51 @@ grow_lo_array(struct picotm_lock_manager* self, struct picotm_error* error)
 {
     assert(self);
 
-    /* Allocate an additional first element if array is still
-     * empty. Index 0 is a magic value and never handed out to
-     * lock owners. */
-    size_t new_nlos = !(self->nlos) + self->nlos + 1;
+    size_t nchunks = self->nlos / PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES;
 
-    struct picotm_lock_owner** new_lo = tabresize(self->lo, self->nlos,
-                                                  new_nlos, sizeof(self->lo),
-                                                  error);
-    if (picotm_error_is_set(error)) {
+    if (nchunks == picotm_arraylen(self->lo)) {
+        /* All indices are in use. */
+        picotm_error_set_error_code(error, PICOTM_OUT_OF_MEMORY);
         return;
     }
 
-    struct picotm_lock_owner** beg = picotm_arrayat(new_lo, self->nlos);
-    struct picotm_lock_owner* const * end = picotm_arrayat(new_lo, new_nlos);
+    size_t new_nlos = self->nlos + PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES;
 
-    while (beg < end) {
-        *beg = nullptr;
-        ++beg;
+    unsigned long* free_lo = tabresize(self->free_lo, self->nlos, new_nlos,
+                                       sizeof(*self->free_lo), error);
+    if (picotm_error_is_set(error)) {
+        return;
     }
+    self->free_lo = free_lo;
 
-    self->lo = new_lo;
-    self->nlos = new_nlos;
-}
-
-static int
-ptrcmp(const void* key, const void* instance)
-{
-    const void* lhs = *((const void* const *)key);
-    const void* rhs = *((const void* const *)instance);
-
-    return (lhs > rhs) - (lhs < rhs);
-}
+    struct picotm_lock_owner** chunk =
+        tabresize(nullptr, 0, PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES,
+                  sizeof(*chunk), error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
 
-/*
- * Requires writer lock on lock_manager::lo_rwlock
- *
- * The find_lo() function always skips the first element of
- * |self->lo|. The index of 0 is a magic value, so we don't
- * hand it out to lock owners.
- */
-static struct picotm_lock_owner**
-find_lo(struct picotm_lock_manager* self, struct picotm_lock_owner* lo,
-        struct picotm_error* error)
-{
-    static const struct picotm_lock_owner* key = nullptr;
-    size_t nlos = self->nlos - !!(self->nlos);
+    struct picotm_lock_owner** beg = chunk;
+    struct picotm_lock_owner* const * end =
+        picotm_arrayat(chunk, PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES);
 
-    struct picotm_lock_owner** pos = lfind(&key, self->lo + (!!nlos), &nlos,
-                                           sizeof(*self->lo), ptrcmp);
-    if (pos) {
-        return pos;
+    while (beg < end) {
+        *beg = nullptr;
+        ++beg;
     }
 
-    nlos = self->nlos;
+    self->lo[nchunks] = chunk;
 
-    grow_lo_array(self, error);
-    if (picotm_error_is_set(error)) {
-        return nullptr;
+    /* Push the new indices in reverse order, so that lower indices
+     * are handed out first. Index 0 is a magic value and never handed
+     * out to lock owners. */
+    for (size_t index = new_nlos; index > self->nlos; --index) {
+        if (index - 1) {
+            self->free_lo[self->nfree_los++] = index - 1;
+        }
     }
 
-    pos = self->lo + (!nlos) + nlos;
-    assert(pos != self->lo);
-    assert(!(*pos));
-
-    return pos;
+    self->nlos = new_nlos;
 }
 
 void
@@ -154,20 +160,25 @@ picotm_lock_manager_register_owner(struct picotm_lock_manager* self,
         return;
     }
 
-    struct picotm_lock_owner** pos = find_lo(self, nullptr, error);
-    if (picotm_error_is_set(error)) {
-        goto err_find_lo;
+    if (!self->nfree_los) {
+        grow_lo_array(self, error);
+        if (picotm_error_is_set(error)) {
+            goto err_grow_lo_array;
+        }
     }
 
+    unsigned long index = self->free_lo[--self->nfree_los];
+
+    struct picotm_lock_owner** pos = lo_at(self, index);
     assert(!(*pos));
     *pos = lo;
-    picotm_lock_owner_set_index(lo, pos - self->lo);
+    picotm_lock_owner_set_index(lo, index);
 
     picotm_os_rwlock_unlock(&self->lo_rwlock);
 
     return;
 
-err_find_lo:
+err_grow_lo_array:
     picotm_os_rwlock_unlock(&self->lo_rwlock);
 }
 
@@ -188,7 +199,13 @@ picotm_lock_manager_unregister_owner(struct picotm_lock_manager* self,
         break;
     } while (true);
 
-    self->lo[picotm_lock_owner_get_index(lo)] = nullptr;
+    unsigned long index = picotm_lock_owner_get_index(lo);
+
+    *lo_at(self, index) = nullptr;
+
+    /* The stack holds all allocated indices; pushing cannot fail. */
+    assert(self->nfree_los < self->nlos);
+    self->free_lo[self->nfree_los++] = index;
 
     picotm_os_rwlock_unlock(&self->lo_rwlock);
 }
@@ -197,6 +214,57 @@ picotm_lock_manager_unregister_owner(struct picotm_lock_manager* self,
  * Irrevocability
  */
 
+/* Returns true if the lock owner at 'index' runs non-exclusively, or
+ * false if the index is unused. Sets 'nlos' to the current number of
+ * lock owners. */
+static bool
+is_non_exclusive_lo_at(struct picotm_lock_manager* self,
+                       unsigned long index, unsigned long* nlos,
+                       struct picotm_error* error)
+{
+    picotm_os_rwlock_rdlock(&self->lo_rwlock, error);
+    if (picotm_error_is_set(error)) {
+        return false;
+    }
+
+    *nlos = self->nlos;
+
+    bool is_non_exclusive = false;
+    if (index < *nlos) {
+        struct picotm_lock_owner* lo = *lo_at(self, index);
+        is_non_exclusive = lo && picotm_lock_owner_is_non_exclusive(lo);
+    }
+
+    picotm_os_rwlock_unlock(&self->lo_rwlock);
+
+    return is_non_exclusive;
+}
+
+static void
+wait_for_non_exclusive_los(struct picotm_lock_manager* self,
+                           struct picotm_error* error)
+{
+    static const struct timespec sleep_time = {0, 50};
+
+    /* We only hold the lock-owner lock while we test a single lock
+     * owner. Sleeping with the lock held would block threads that
+     * register or unregister lock owners for as long as we wait. */
+
+    unsigned long nlos = 2;
+
+    for (unsigned long index = 1; index < nlos; ++index) {
+        while (is_non_exclusive_lo_at(self, index, &nlos, error)) {
+            picotm_os_nanosleep(&sleep_time, error);
+            if (picotm_error_is_set(error)) {
+                return;
+            }
+        }
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
 void
 picotm_lock_manager_make_irrevocable(struct picotm_lock_manager* self,
                                      struct picotm_lock_owner* exclusive_lo,
@@ -210,19 +278,98 @@ picotm_lock_manager_make_irrevocable(struct picotm_lock_manager* self,
         return;
     }
 
+    /* Sequential consistency orders the store before loading the
+     * lock owners' flags. New non-exclusive lock owners will see the
+     * flag and wait for us. */
+    atomic_store_explicit(&self->has_exclusive_lo, true,
+                          memory_order_seq_cst);
+
+    wait_for_non_exclusive_los(self, error);
+    if (picotm_error_is_set(error)) {
+        goto err_wait_for_non_exclusive_los;
+    }
+
     self->exclusive_lo = exclusive_lo;
+
+    return;
+
+err_wait_for_non_exclusive_los:
+    atomic_store_explicit(&self->has_exclusive_lo, false,
+                          memory_order_release);
+    picotm_os_rwlock_unlock(&self->exclusive_lo_lock);
+}
+
+static void
+enter_non_exclusive(struct picotm_lock_manager* self,
+                    struct picotm_lock_owner* lo,
+                    struct picotm_error* error)
+{
+    do {
+        /* We announce ourselves *before* testing for an exclusive
+         * lock owner, which sets its flag *before* testing ours. At
+         * least one of us sees the other. */
+        picotm_lock_owner_set_non_exclusive(lo, true);
+
+        bool has_exclusive_lo =
+            atomic_load_explicit(&self->has_exclusive_lo,
+                                 memory_order_seq_cst);
+        if (!has_exclusive_lo) {
+            return;
+        }
+
+        picotm_lock_owner_set_non_exclusive(lo, false);
+
+        /* Block until the exclusive lock owner releases its lock. */
+        picotm_os_rwlock_rdlock(&self->exclusive_lo_lock, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        picotm_os_rwlock_unlock(&self->exclusive_lo_lock);
+
+    } while (true);
 }
 
 void
-picotm_lock_manager_wait_irrevocable(struct picotm_lock_manager* self,
+picotm_lock_manager_make_prioritized(struct picotm_lock_manager* self,
+                                     struct picotm_lock_owner* lo,
                                      struct picotm_error* error)
 {
     assert(self);
+    assert(lo);
 
-    picotm_os_rwlock_rdlock(&self->exclusive_lo_lock, error);
+    picotm_os_mutex_lock(&self->prioritized_lo_mutex, error);
     if (picotm_error_is_set(error)) {
         return;
     }
+
+    /* Prioritized lock owners are non-exclusive. */
+    enter_non_exclusive(self, lo, error);
+    if (picotm_error_is_set(error)) {
+        goto err_enter_non_exclusive;
+    }
+
+    picotm_lock_owner_set_prioritized(lo, true, error);
+    if (picotm_error_is_set(error)) {
+        goto err_picotm_lock_owner_set_prioritized;
+    }
+
+    return;
+
+err_picotm_lock_owner_set_prioritized:
+    picotm_lock_owner_set_non_exclusive(lo, false);
+err_enter_non_exclusive:
+    picotm_os_mutex_unlock(&self->prioritized_lo_mutex);
+}
+
+void
+picotm_lock_manager_wait_irrevocable(struct picotm_lock_manager* self,
+                                     struct picotm_lock_owner* lo,
+                                     struct picotm_error* error)
+{
+    assert(self);
+    assert(lo);
+
+    enter_non_exclusive(self, lo, error);
 }
 
 void
@@ -232,9 +379,28 @@ picotm_lock_manager_release_irrevocability(struct picotm_lock_manager* self,
     assert(self);
     assert(self->exclusive_lo == lo || !self->exclusive_lo);
 
-    if (self->exclusive_lo == lo)
+    if (self->exclusive_lo == lo) {
         self->exclusive_lo = nullptr;
-    picotm_os_rwlock_unlock(&self->exclusive_lo_lock);
+        atomic_store_explicit(&self->has_exclusive_lo, false,
+                              memory_order_release);
+        picotm_os_rwlock_unlock(&self->exclusive_lo_lock);
+    } else {
+        picotm_lock_owner_set_non_exclusive(lo, false);
+    }
+
+    if (picotm_lock_owner_is_prioritized(lo)) {
+        do {
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_lock_owner_set_prioritized(lo, false, &error);
+            if (picotm_error_is_set(&error)) {
+                picotm_error_mark_as_non_recoverable(&error);
+                picotm_recover_from_error(&error);
+                continue;
+            }
+            break;
+        } while (true);
+        picotm_os_mutex_unlock(&self->prioritized_lo_mutex);
+    }
 }
 
 /*
@@ -267,7 +433,7 @@ lock_and_prepend_waiter(struct picotm_lock_manager* self,
         /* We retrieve the instance of the current first entry in the
          * waiter list. */
         assert(first_index < self->nlos);
-        first_waiter = self->lo[first_index];
+        first_waiter = *lo_at(self, first_index);
 
         /* At this point we have the index and instance of the first waiter
          * in the list. The list and the first waiter itself is not locked,
@@ -325,7 +491,7 @@ get_first_waiter(struct picotm_lock_manager* self,
     while (first_index && !first_waiter) {
 
         assert(first_index < self->nlos);
-        first_waiter = self->lo[first_index];
+        first_waiter = *lo_at(self, first_index);
 
         picotm_lock_owner_lock(first_waiter, error);
         if (picotm_error_is_set(error)) {
@@ -509,37 +675,216 @@ out:
  * Waiting
  */
 
+/*
+ * Contention management
+ *
+ * Each contention-management policy provides a function that decides
+ * if a lock owner waits for a lock, and for how long, and a function
+ * that compares two waiters when a lock becomes available. Deciding
+ * doesn't require the current time. Only lock owners that actually
+ * wait read the clock.
+ */
+
+/* Lock owners below this age don't wait with the Greedy policy. */
+static const struct timespec GREEDY_MIN_AGE = {0, 1000000};
+
+/* Lock owners below this karma don't wait with the Karma policy. */
+static const unsigned long KARMA_MIN_KARMA = 64;
+
+static bool
+should_wait_greedy(const struct picotm_lock_owner* waiter,
+                   struct timespec* wait_time)
+{
+    static const struct timespec max_wait = {0, 100000};
+
+    /* The first timestamp comes from the coarse clock, so the
+     * age is only accurate to the coarse clock's granularity. */
+    struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+    struct timespec age;
+    picotm_os_get_coarse_timespec(&age, &error);
+    if (picotm_error_is_set(&error)) {
+        return false;
+    }
+    picotm_os_sub_timespec(&age,
+                           picotm_lock_owner_get_first_timestamp(waiter));
+
+    if (picotm_os_timespec_compare(&age, &GREEDY_MIN_AGE) < 0) {
+        /* We still have a very young transaction. Suspending would
+         * add a significant amound of overhead. We simple bail out
+         * here. */
+        return false;
+    }
+
+    *wait_time = max_wait;
+
+    return true;
+}
+
+static bool
+should_wait_karma(const struct picotm_lock_owner* waiter,
+                  struct timespec* wait_time)
+{
+    static const struct timespec max_wait = {0, 100000};
+
+    if (picotm_lock_owner_get_karma(waiter) < KARMA_MIN_KARMA) {
+        /* Aborting throws away little work. */
+        return false;
+    }
+
+    *wait_time = max_wait;
+
+    return true;
+}
+
+static bool
+should_wait_polka(const struct picotm_lock_owner* waiter,
+                  struct timespec* wait_time)
+{
+    /* Exponential back-off: 1 us, doubled on each restart, up to
+     * about 1 ms. */
+    unsigned long shift = waiter->nretries < 10 ? waiter->nretries : 10;
+
+    wait_time->tv_sec = 0;
+    wait_time->tv_nsec = 1000l << shift;
+
+    return true;
+}
+
+static bool
+should_wait_passive(const struct picotm_lock_owner* waiter,
+                    struct timespec* wait_time)
+{
+    return false;
+}
+
+static bool
+should_wait_aggressive(const struct picotm_lock_owner* waiter,
+                       struct timespec* wait_time)
+{
+    static const struct timespec max_wait = {0, 1000000};
+
+    *wait_time = max_wait;
+
+    return true;
+}
+
+static int
+compare_longest_waiting(const struct picotm_lock_owner* old_waiter,
+                        const struct picotm_lock_owner* new_waiter)
+{
+    assert(old_waiter);
+    assert(new_waiter);
+
+    return 1;
+}
+
+static int
+compare_longest_running(const struct picotm_lock_owner* old_waiter,
+                        const struct picotm_lock_owner* new_waiter)
+{
+    assert(old_waiter);
+    assert(new_waiter);
+
+    return picotm_os_timespec_compare(
+        picotm_lock_owner_get_first_timestamp(old_waiter),
+        picotm_lock_owner_get_first_timestamp(new_waiter));
+}
+
+static int
+compare_highest_karma(const struct picotm_lock_owner* old_waiter,
+                      const struct picotm_lock_owner* new_waiter)
+{
+    assert(old_waiter);
+    assert(new_waiter);
+
+    unsigned long old_karma = picotm_lock_owner_get_karma(old_waiter);
+    unsigned long new_karma = picotm_lock_owner_get_karma(new_waiter);
+
+    return (new_karma > old_karma) - (new_karma < old_karma);
+}
+
+struct contention_policy {
+    bool (*should_wait)(const struct picotm_lock_owner*, struct timespec*);
+    int (*compare_waiters)(const struct picotm_lock_owner*,
+                           const struct picotm_lock_owner*);
+};
+
+static const struct contention_policy*
+get_contention_policy(void)
+{
+    static const struct contention_policy s_policy[] = {
+        [PICOTM_CONTENTION_POLICY_GREEDY] = {
+            should_wait_greedy,
+            compare_longest_running
+        },
+        [PICOTM_CONTENTION_POLICY_KARMA] = {
+            should_wait_karma,
+            compare_highest_karma
+        },
+        [PICOTM_CONTENTION_POLICY_POLKA] = {
+            should_wait_polka,
+            compare_highest_karma
+        },
+        [PICOTM_CONTENTION_POLICY_PASSIVE] = {
+            should_wait_passive,
+            compare_longest_waiting
+        },
+        [PICOTM_CONTENTION_POLICY_AGGRESSIVE] = {
+            should_wait_aggressive,
+            compare_longest_waiting
+        }
+    };
+
+    return s_policy + picotm_contention_get_policy();
+}
+
+/*
+ * Waiting
+ */
+
+/* Returns the absolute timeout in 'timeout', if the waiter should
+ * wait. */
 static bool
 compute_timeout(struct picotm_lock_owner* waiter, struct timespec* timeout,
                 struct picotm_error* error)
 {
-    static const struct timespec one_second = {
-        1, 0
+    static const struct timespec prioritized_wait = {
+        0, 100000
     };
 
+    struct timespec wait_time;
+
+    if (picotm_lock_owner_is_prioritized(waiter)) {
+        /* A prioritized lock owner always waits for the lock. Other
+         * lock owners wake it up as soon as they release the lock. The
+         * timeout only guards against missed wake-ups. */
+        wait_time = prioritized_wait;
+    } else if (!get_contention_policy()->should_wait(waiter, &wait_time)) {
+        return false;
+    }
+
     picotm_os_get_timespec(timeout, error);
     if (picotm_error_is_set(error)) {
         return false;
     }
 
-    struct timespec timediff;
-    memcpy(&timediff, timeout, sizeof(timediff));
+    picotm_os_add_timespec(timeout, &wait_time);
+
+    return true;
+}
 
-    picotm_os_sub_timespec(&timediff, picotm_lock_owner_get_timestamp(waiter));
+bool
+picotm_lock_manager_should_wait(const struct picotm_lock_manager* self,
+                                const struct picotm_lock_owner* waiter)
+{
+    assert(self);
 
-    int cmp = picotm_os_timespec_compare(&timediff, &one_second);
-    if (cmp < 0) {
-        /* We still have a very short transaction. Suspending would
-         * add a significant amound of overhead. We simple bail out
-         * here. */
-        return false;
+    if (picotm_lock_owner_is_prioritized(waiter)) {
+        return true;
     }
 
-    timediff.tv_sec = 0;
-    timediff.tv_nsec = 1000;
-    picotm_os_add_timespec(timeout, &timediff);
-
-    return true;
+    struct timespec wait_time;
+    return get_contention_policy()->should_wait(waiter, &wait_time);
 }
 
 bool
@@ -561,6 +906,15 @@ picotm_lock_manager_wait(struct picotm_lock_manager* self,
         return false;
     }
 
+    /* The wait time only goes into the statistics, so we take it from
+     * the coarse clock. Each measurement is off by up to a clock tick,
+     * but the errors average out in the accumulated wait time. */
+    struct timespec wait_beg;
+    picotm_os_get_coarse_timespec(&wait_beg, error);
+    if (picotm_error_is_set(error)) {
+        return false;
+    }
+
     /* On success, we will have acquired a lock on 'waiter'. */
     lock_and_prepend_waiter(self, waiter, slist_funcs, slist, error);
     if (picotm_error_is_set(error)) {
@@ -569,11 +923,24 @@ picotm_lock_manager_wait(struct picotm_lock_manager* self,
 
     waiter->flags |= wr ? LOCK_OWNER_WR : LOCK_OWNER_RD;
 
+    PICOTM_TRACE(PICOTM_TRACE_WAIT_BEGIN, picotm_lock_owner_get_index(waiter));
+
     bool woken_up = picotm_lock_owner_wait_until(waiter, &timeout, error);
     if (picotm_error_is_set(error)) {
         goto err_picotm_lock_owner_locked_wait;
     }
 
+    PICOTM_TRACE(PICOTM_TRACE_WAIT_END, woken_up);
+
+    struct timespec wait_end;
+    picotm_os_get_coarse_timespec(&wait_end, error);
+    if (picotm_error_is_set(error)) {
+        goto err_picotm_lock_owner_locked_wait;
+    }
+
+    picotm_tx_stats_add_wait_time(picotm_lock_owner_get_tx_stats(waiter),
+                                  &wait_beg, &wait_end);
+
     struct picotm_lock_owner* prec_waiter = remove_waiter(self, waiter, nullptr,
                                                           slist_funcs, slist);
     if (prec_waiter) {
@@ -627,8 +994,10 @@ pick_waiter(struct picotm_lock_owner* first_waiter,
             if (!picked_waiter) {
                 picked_waiter = waiter;
 
-            } else {
-                int cmp = compare_waiters(picked_waiter, waiter);
+            } else if (!picotm_lock_owner_is_prioritized(picked_waiter)) {
+                /* A prioritized waiter is always picked. */
+                int cmp = picotm_lock_owner_is_prioritized(waiter)
+                            ? 1 : compare_waiters(picked_waiter, waiter);
                 if (cmp > 0) {
                     if (picked_waiter != first_waiter) {
                         picotm_lock_owner_unlock(picked_waiter);
@@ -666,50 +1035,12 @@ pick_waiter(struct picotm_lock_owner* first_waiter,
     return picked_waiter;
 }
 
-static int
-compare_longest_waiting(const struct picotm_lock_owner* old_waiter,
-                        const struct picotm_lock_owner* new_waiter)
-{
-    assert(old_waiter);
-    assert(new_waiter);
-
-    return 1;
-}
-
-static int
-compare_longest_running(const struct picotm_lock_owner* old_waiter,
-                        const struct picotm_lock_owner* new_waiter)
-{
-    assert(old_waiter);
-    assert(new_waiter);
-
-    return picotm_os_timespec_compare(picotm_lock_owner_get_timestamp(old_waiter),
-                                      picotm_lock_owner_get_timestamp(new_waiter));
-}
-
-static int
-compare_shortest_waiting(const struct picotm_lock_owner* old_waiter,
-                         const struct picotm_lock_owner* new_waiter)
-{
-    assert(old_waiter);
-    assert(new_waiter);
-
-    return 0;
-}
-
 void
 picotm_lock_manager_wake_up(struct picotm_lock_manager* self,
                             bool concurrent_readers_supported,
                             const struct picotm_lock_slist_funcs* slist_funcs,
                             void* slist, struct picotm_error* error)
 {
-    static int (* const compare_waiters[])(const struct picotm_lock_owner*,
-                                           const struct picotm_lock_owner*) = {
-        compare_longest_waiting,
-        compare_longest_running,
-        compare_shortest_waiting
-    };
-
     assert(self);
 
     picotm_os_rwlock_rdlock(&self->lo_rwlock, error);
@@ -729,9 +1060,9 @@ picotm_lock_manager_wake_up(struct picotm_lock_manager* self,
         goto out;
     }
 
-    struct picotm_lock_owner* picked_waiter = pick_waiter(first_waiter,
-                                                          compare_waiters[0],
-                                                          error);
+    struct picotm_lock_owner* picked_waiter =
+        pick_waiter(first_waiter, get_contention_policy()->compare_waiters,
+                    error);
     if (picotm_error_is_set(error)) {
         goto err_pick_next;
     }
@@ -751,6 +1082,9 @@ picotm_lock_manager_wake_up(struct picotm_lock_manager* self,
         goto err_picotm_lock_owner_wake_up;
     }
 
+    PICOTM_TRACE(PICOTM_TRACE_WAKE_UP,
+                 picotm_lock_owner_get_index(picked_waiter));
+
     bool wake_up_all_readers =
         concurrent_readers_supported
             && (picked_waiter->flags & LOCK_OWNER_RD);
@@ -786,6 +1120,8 @@ picotm_lock_manager_wake_up(struct picotm_lock_manager* self,
                     picotm_os_rwlock_unlock(&self->lo_rwlock);
                     return;
                 }
+                PICOTM_TRACE(PICOTM_TRACE_WAKE_UP,
+                             picotm_lock_owner_get_index(waiter));
             }
 
             prec_waiter = waiter;
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include "picotm_lock_owner.h"
+#include "picotm_os_mutex.h"
 #include "picotm_os_rwlock.h"
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -43,25 +46,67 @@ struct picotm_lock_slist_funcs {
     unsigned long (*cmpxchg_first_index)(void*, unsigned long, unsigned long);
 };
 
+/**
+ * \brief The number of lock-owner entries per chunk.
+ */
+#define PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES   (256)
+
+/**
+ * \brief The maximum number of lock-owner chunks.
+ */
+#define PICOTM_LOCK_MANAGER_LO_NCHUNKS \
+    ((PICOTM_LOCK_OWNER_MAX_INDEX + 1) / PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES)
+
 /**
  * \brief Coordinates among lock owners contending for locks.
  */
 struct picotm_lock_manager {
 
-    struct picotm_os_rwlock    lo_rwlock;
-    struct picotm_lock_owner** lo;
+    struct picotm_os_rwlock lo_rwlock;
+
+    /**
+     * The registered lock owners, stored in chunks of
+     * `PICOTM_LOCK_MANAGER_LO_CHUNK_NENTRIES` entries. Chunks are
+     * allocated on demand and never moved. A lock owner's index
+     * selects the chunk and the entry within the chunk. Index 0 is
+     * a magic value and never handed out to lock owners.
+     */
+    struct picotm_lock_owner** lo[PICOTM_LOCK_MANAGER_LO_NCHUNKS];
     size_t                     nlos;
 
+    /**
+     * Stack of indices of unused entries in `lo`. It's large
+     * enough to hold the indices of all allocated entries.
+     */
+    unsigned long* free_lo;
+    size_t         nfree_los;
+
     /**
      * Locks the transaction system for either one exclusive lock owner,
      * or multiple non-exclusive lock owners.
      *
-     * \todo This lock implements irrevocability. Replace this lock with a
-     * more fine-grained system that allows recovable transactions while an
-     * irrevocable transaction is present.
+     * This lock implements irrevocability. Lock owners that only
+     * require progress, but no irrevocability, should be prioritized
+     * instead.
+     *
+     * Non-exclusive lock owners don't acquire the lock. Each announces
+     * itself in its own flag, `is_non_exclusive`, and tests
+     * `has_exclusive_lo`. An exclusive lock owner holds the writer lock,
+     * sets `has_exclusive_lo` and waits for all flags to clear. A
+     * non-exclusive lock owner that finds `has_exclusive_lo` set waits
+     * on a reader lock.
      */
     struct picotm_os_rwlock   exclusive_lo_lock;
     struct picotm_lock_owner* exclusive_lo;
+    atomic_bool               has_exclusive_lo;
+
+    /**
+     * Serializes prioritized lock owners. A prioritized lock owner runs
+     * concurrently with other non-exclusive lock owners, but wins all
+     * conflicts over locks. At most one lock owner is prioritized at a
+     * time.
+     */
+    struct picotm_os_mutex prioritized_lo_mutex;
 };
 
 /**
@@ -119,23 +164,56 @@ picotm_lock_manager_make_irrevocable(struct picotm_lock_manager* self,
                                      struct picotm_lock_owner* exclusive_lo,
                                      struct picotm_error* error);
 
+/**
+ * \brief Prioritizes a lock owner over all other lock owners.
+ * \param self The lock manager.
+ * \param lo The lock owner that is to become prioritized.
+ * \param[out] error Returns an error to the caller.
+ *
+ * A prioritized lock owner wins all conflicts over locks. It waits for
+ * locks to become available instead of reporting a conflict, and it's
+ * woken up before other waiters. Other lock owners continue to run
+ * concurrently, unless they conflict with the prioritized lock owner.
+ * Prioritization is released by
+ * `picotm_lock_manager_release_irrevocability()`.
+ */
+void
+picotm_lock_manager_make_prioritized(struct picotm_lock_manager* self,
+                                     struct picotm_lock_owner* lo,
+                                     struct picotm_error* error);
+
 /**
  * \brief Waits for an irrevocable lock owner to complete.
  * \param self The lock manager.
+ * \param lo The lock owner that is to run non-exclusively.
  * \param[out] error Returns an error to the caller.
  */
 void
 picotm_lock_manager_wait_irrevocable(struct picotm_lock_manager* self,
+                                     struct picotm_lock_owner* lo,
                                      struct picotm_error* error);
 
 /**
- * \brief Unblocks irrevocability for other lock owners.
+ * \brief Unblocks irrevocability or prioritization for other lock owners.
  * \param self The lock manager.
+ * \param lo The lock owner.
  */
 void
 picotm_lock_manager_release_irrevocability(struct picotm_lock_manager* self,
                                            struct picotm_lock_owner* lo);
 
+/**
+ * \brief Asks the contention-management policy if a lock owner should
+ *        wait for a conflicting lock.
+ * \param self The lock manager.
+ * \param lo The lock owner.
+ * \returns True if the lock owner should wait, or false if it should
+ *          signal a conflict immediately.
+ */
+bool
+picotm_lock_manager_should_wait(const struct picotm_lock_manager* self,
+                                const struct picotm_lock_owner* lo);
+
 /**
  * \brief Instructs a lock manager to setup a lock owner for waiting.
  * \param self The lock manager.
@@ -19,6 +19,7 @@
 
 #include "picotm_lock_owner.h"
 #include <assert.h>
+#include <stdint.h>
 #include "picotm_os_timespec.h"
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-module.h"
@@ -41,6 +42,14 @@ picotm_lock_owner_init(struct picotm_lock_owner* self,
 
     self->flags = 0;
     self->next = nullptr;
+    self->nretries = 0;
+    self->karma = 0;
+    self->is_prioritized = false;
+    self->is_readonly = false;
+    atomic_init(&self->is_non_exclusive, false);
+    self->backoff.nspins = 0;
+    /* Any non-zero seed works with xorshift. */
+    self->backoff.seed = (uintptr_t)self | 1;
 
     return;
 
@@ -57,14 +66,20 @@ picotm_lock_owner_uninit(struct picotm_lock_owner* self)
     picotm_os_cond_uninit(&self->wait_cond);
 }
 
+/** \brief Bitmask of the index in 'struct picotm_lock_owner::flags' */
+static const unsigned long INDEX_BIT_MASK = PICOTM_LOCK_OWNER_MAX_INDEX;
+
+/** \brief Offset of the next index in 'struct picotm_lock_owner::flags' */
+static const unsigned long NEXT_BIT_SHIFT = PICOTM_LOCK_OWNER_INDEX_NBITS;
+
 void
 picotm_lock_owner_set_index(struct picotm_lock_owner* self,
                             unsigned long index)
 {
     assert(self);
-    assert(index < (1ul << 10));
+    assert(index <= PICOTM_LOCK_OWNER_MAX_INDEX);
 
-    self->flags = (self->flags & ~0x3ff) | (index & 0x3ff);
+    self->flags = (self->flags & ~INDEX_BIT_MASK) | (index & INDEX_BIT_MASK);
 }
 
 unsigned long
@@ -72,7 +87,7 @@ picotm_lock_owner_get_index(const struct picotm_lock_owner* self)
 {
     assert(self);
 
-    return self->flags & 0x3ff;
+    return self->flags & INDEX_BIT_MASK;
 }
 
 void
@@ -80,9 +95,10 @@ picotm_lock_owner_set_next(struct picotm_lock_owner* self,
                            unsigned long next)
 {
     assert(self);
-    assert(next < (1ul << 10));
+    assert(next <= PICOTM_LOCK_OWNER_MAX_INDEX);
 
-    self->flags = (self->flags & ~0xffc00) | ((next & 0x3ff) << 10);
+    self->flags = (self->flags & ~(INDEX_BIT_MASK << NEXT_BIT_SHIFT)) |
+                  ((next & INDEX_BIT_MASK) << NEXT_BIT_SHIFT);
 }
 
 unsigned long
@@ -90,27 +106,120 @@ picotm_lock_owner_get_next(const struct picotm_lock_owner* self)
 {
     assert(self);
 
-    return (self->flags >> 10) & 0x3ff;
+    return (self->flags >> NEXT_BIT_SHIFT) & INDEX_BIT_MASK;
+}
+
+void
+picotm_lock_owner_reset_timestamp(struct picotm_lock_owner* self,
+                                  unsigned long nretries,
+                                  struct picotm_error* error)
+{
+    assert(self);
+
+    if (!nretries) {
+        picotm_os_get_coarse_timespec(&self->first_timestamp, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        self->karma = 0;
+    }
+    self->nretries = nretries;
 }
 
 const struct timespec*
-picotm_lock_owner_get_timestamp(const struct picotm_lock_owner* self)
+picotm_lock_owner_get_first_timestamp(const struct picotm_lock_owner* self)
 {
     assert(self);
 
-    return &self->timestamp;
+    return &self->first_timestamp;
 }
 
 void
-picotm_lock_owner_reset_timestamp(struct picotm_lock_owner* self,
+picotm_lock_owner_add_karma(struct picotm_lock_owner* self,
+                            unsigned long nevents)
+{
+    assert(self);
+
+    self->karma += nevents;
+}
+
+unsigned long
+picotm_lock_owner_get_karma(const struct picotm_lock_owner* self)
+{
+    assert(self);
+
+    return self->karma;
+}
+
+void
+picotm_lock_owner_set_prioritized(struct picotm_lock_owner* self,
+                                  bool is_prioritized,
                                   struct picotm_error* error)
 {
     assert(self);
 
-    picotm_os_get_timespec(&self->timestamp, error);
+    picotm_lock_owner_lock(self, error);
     if (picotm_error_is_set(error)) {
         return;
     }
+
+    self->is_prioritized = is_prioritized;
+
+    picotm_lock_owner_unlock(self);
+}
+
+bool
+picotm_lock_owner_is_prioritized(const struct picotm_lock_owner* self)
+{
+    assert(self);
+
+    return self->is_prioritized;
+}
+
+void
+picotm_lock_owner_set_readonly(struct picotm_lock_owner* self,
+                               bool is_readonly)
+{
+    assert(self);
+
+    self->is_readonly = is_readonly;
+}
+
+bool
+picotm_lock_owner_is_readonly(const struct picotm_lock_owner* self)
+{
+    assert(self);
+
+    return self->is_readonly;
+}
+
+void
+picotm_lock_owner_set_non_exclusive(struct picotm_lock_owner* self,
+                                    bool is_non_exclusive)
+{
+    assert(self);
+
+    /* Sequential consistency orders the store before the lock
+     * manager's subsequent test for an exclusive lock owner. */
+    atomic_store_explicit(&self->is_non_exclusive, is_non_exclusive,
+                          memory_order_seq_cst);
+}
+
+bool
+picotm_lock_owner_is_non_exclusive(struct picotm_lock_owner* self)
+{
+    assert(self);
+
+    return atomic_load_explicit(&self->is_non_exclusive,
+                                memory_order_seq_cst);
+}
+
+struct picotm_lock_owner_backoff*
+picotm_lock_owner_get_backoff(struct picotm_lock_owner* self)
+{
+    assert(self);
+
+    return &self->backoff;
 }
 
 void
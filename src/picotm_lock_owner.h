@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <time.h>
 #include "picotm_os_cond.h"
@@ -33,6 +35,13 @@
 
 struct picotm_error;
 
+/** \brief The number of bits in a lock owner's index */
+#define PICOTM_LOCK_OWNER_INDEX_NBITS   (14)
+
+/** \brief The largest index of a lock owner */
+#define PICOTM_LOCK_OWNER_MAX_INDEX \
+    ((1ul << PICOTM_LOCK_OWNER_INDEX_NBITS) - 1)
+
 /** \brief Lock owner is waiting */
 static const unsigned long LOCK_OWNER_WT = 1ul << 29;
 /** \brief Lock owner is waiting to acquire a reader lock */
@@ -40,6 +49,26 @@ static const unsigned long LOCK_OWNER_RD = 1ul << 30;
 /** \brief Lock owner is waiting to acquire a writer lock*/
 static const unsigned long LOCK_OWNER_WR = 1ul << 31;
 
+/**
+ * \brief The adaptive back-off state of a lock owner.
+ *
+ * Only the lock owner's own thread accesses the back-off state.
+ */
+struct picotm_lock_owner_backoff {
+
+    /** Average number of iterations of recent successful spinning */
+    unsigned long nspins;
+
+    /** State of the pseudo-random number generator */
+    unsigned long seed;
+};
+
+/**
+ * The size of a cache line. Fields of a lock owner that other threads
+ * poll are aligned to this size.
+ */
+#define PICOTM_LOCK_OWNER_CACHE_LINE_SIZE   64
+
 /**
  * \brief Represents the potential owner of a lock.
  */
@@ -48,16 +77,54 @@ struct picotm_lock_owner {
     /**
      * \brief Encodes information about the owner of a lock.
      *
-     * | 31 | 30 | 29 | 19    ...     10 | 9 .. 0 |
-     * | WR | RD | WT |    < empty >     | index  |
+     * | 31 | 30 | 29 |    28     | 27 ... 14 | 13 ... 0 |
+     * | WR | RD | WT | < empty > |   next    |  index   |
      */
     unsigned long flags;
 
     /** Entry in waiter list */
     struct picotm_lock_owner* next;
 
-    /** Start time of the lock owner's transaction*/
-    struct timespec timestamp;
+    /**
+     * Start time of the first attempt of the lock owner's transaction,
+     * taken from the coarse clock
+     */
+    struct timespec first_timestamp;
+
+    /** Number of restarts of the lock owner's transaction */
+    unsigned long nretries;
+
+    /**
+     * Number of events logged by the lock owner's transaction,
+     * including all restarts
+     */
+    unsigned long karma;
+
+    /**
+     * True if the lock owner wins all conflicts over locks. Only the
+     * lock owner's thread modifies this field while holding the lock
+     * owner's mutex.
+     */
+    bool is_prioritized;
+
+    /**
+     * True if the lock owner's transaction promised not to modify any
+     * resources. Only the lock owner's thread accesses this field.
+     */
+    bool is_readonly;
+
+    /**
+     * True while the lock owner runs non-exclusively. The flags of
+     * all lock owners form a distributed reader indicator for the
+     * lock manager's exclusive lock owner. The flag changes with
+     * every transaction and other threads poll it, so it occupies a
+     * cache line of its own.
+     */
+    alignas(PICOTM_LOCK_OWNER_CACHE_LINE_SIZE) atomic_bool is_non_exclusive;
+
+    /** The lock owner's back-off state */
+    alignas(PICOTM_LOCK_OWNER_CACHE_LINE_SIZE)
+    struct picotm_lock_owner_backoff backoff;
 
     struct picotm_os_cond  wait_cond;
     struct picotm_os_mutex mutex;
@@ -116,19 +183,120 @@ picotm_lock_owner_get_next(const struct picotm_lock_owner* self);
 /**
  * \brief Resets a lock owner's timestamp.
  * \param self The lock owner.
+ * \param nretries The number of restarts of the lock owner's transaction.
  * \param[out] error Returns an error to the caller.
+ *
+ * On the first attempt of a transaction, the function resets the lock
+ * owner's first timestamp and karma. The timestamp only orders lock
+ * owners for contention management, so it's read from the coarse
+ * clock. Restarts don't read the clock at all.
  */
 void
 picotm_lock_owner_reset_timestamp(struct picotm_lock_owner* self,
+                                  unsigned long nretries,
                                   struct picotm_error* error);
 
 /**
- * \brief Returns a lock owner's timestamp.
+ * \brief Returns the timestamp of a lock owner's first attempt.
  * \param self The lock owner.
- * \returns The timestamp of the lock owner.
+ * \returns The lock owner's first timestamp.
  */
 const struct timespec*
-picotm_lock_owner_get_timestamp(const struct picotm_lock_owner* self);
+picotm_lock_owner_get_first_timestamp(const struct picotm_lock_owner* self);
+
+/**
+ * \brief Adds logged events to a lock owner's karma.
+ * \param self The lock owner.
+ * \param nevents The number of logged events.
+ */
+void
+picotm_lock_owner_add_karma(struct picotm_lock_owner* self,
+                            unsigned long nevents);
+
+/**
+ * \brief Returns a lock owner's karma.
+ * \param self The lock owner.
+ * \returns The lock owner's karma.
+ */
+unsigned long
+picotm_lock_owner_get_karma(const struct picotm_lock_owner* self);
+
+/**
+ * \brief Sets or clears a lock owner's priority over other lock owners.
+ * \param self The lock owner.
+ * \param is_prioritized True to prioritize the lock owner, or false
+ *                       otherwise.
+ * \param[out] error Returns an error to the caller.
+ *
+ * Only the lock owner's own thread may call this function.
+ */
+void
+picotm_lock_owner_set_prioritized(struct picotm_lock_owner* self,
+                                  bool is_prioritized,
+                                  struct picotm_error* error);
+
+/**
+ * \brief Tests if a lock owner is prioritized over other lock owners.
+ * \param self The lock owner.
+ * \returns True if the lock owner is prioritized, or false otherwise.
+ *
+ * Callers other than the lock owner's thread have to hold the lock on
+ * the lock owner.
+ */
+bool
+picotm_lock_owner_is_prioritized(const struct picotm_lock_owner* self);
+
+/**
+ * \brief Sets or clears a lock owner's read-only flag.
+ * \param self The lock owner.
+ * \param is_readonly True if the lock owner's transaction is read-only,
+ *                    or false otherwise.
+ *
+ * Only the lock owner's own thread may call this function.
+ */
+void
+picotm_lock_owner_set_readonly(struct picotm_lock_owner* self,
+                               bool is_readonly);
+
+/**
+ * \brief Tests if a lock owner's transaction is read-only.
+ * \param self The lock owner.
+ * \returns True if the lock owner's transaction is read-only, or false
+ *          otherwise.
+ *
+ * Only the lock owner's own thread may call this function.
+ */
+bool
+picotm_lock_owner_is_readonly(const struct picotm_lock_owner* self);
+
+/**
+ * \brief Sets or clears a lock owner's non-exclusive flag.
+ * \param self The lock owner.
+ * \param is_non_exclusive True if the lock owner runs non-exclusively,
+ *                         or false otherwise.
+ *
+ * Only the lock owner's own thread may call this function.
+ */
+void
+picotm_lock_owner_set_non_exclusive(struct picotm_lock_owner* self,
+                                    bool is_non_exclusive);
+
+/**
+ * \brief Tests if a lock owner runs non-exclusively.
+ * \param self The lock owner.
+ * \returns True if the lock owner runs non-exclusively, or false
+ *          otherwise.
+ */
+bool
+picotm_lock_owner_is_non_exclusive(struct picotm_lock_owner* self);
+
+/**
+ * \brief Returns a lock owner's back-off state.
+ * \param self The lock owner.
+ * \returns The lock owner's back-off state.
+ */
+struct picotm_lock_owner_backoff*
+picotm_lock_owner_get_backoff(struct picotm_lock_owner* self);
 
 /**
  * \brief Acquires an exclusive lock on a lock owner.
@@ -20,18 +20,17 @@
 #include "picotm_log.h"
 #include "picotm/picotm-error.h"
 #include <assert.h>
-#include <string.h>
-#include "picotm_event.h"
-#include "table.h"
+#include <errno.h>
+#include <stdlib.h>
 
 void
 picotm_log_init(struct picotm_log* self)
 {
     assert(self);
 
-    self->eventtab = nullptr;
-    self->eventtablen = 0;
-    self->eventtabsiz = 0;
+    self->head = nullptr;
+    self->tail = nullptr;
+    self->tail_nevents = 0;
 }
 
 void
@@ -39,29 +38,83 @@ picotm_log_uninit(struct picotm_log* self)
 {
     assert(self);
 
-    tabfree(self->eventtab);
+    struct picotm_log_block* block = self->head;
+
+    while (block) {
+        struct picotm_log_block* next = block->next;
+        free(block);
+        block = next;
+    }
 }
 
-struct picotm_event*
-picotm_log_begin(struct picotm_log* self)
+bool
+picotm_log_is_empty(const struct picotm_log* self)
 {
     assert(self);
 
-    return self->eventtab;
+    return !self->tail || ((self->tail == self->head) &&
+                           !self->tail_nevents);
 }
 
-const struct picotm_event*
-picotm_log_end(struct picotm_log* self)
+void
+picotm_log_clear(struct picotm_log* self)
 {
     assert(self);
 
-    return self->eventtab + self->eventtablen;
+    /* Keep all blocks for the next transaction. */
+    self->tail = self->head;
+    self->tail_nevents = 0;
 }
 
 void
-picotm_log_clear(struct picotm_log* self)
+picotm_log_get_mark(const struct picotm_log* self,
+                    struct picotm_log_mark* mark)
+{
+    assert(self);
+    assert(mark);
+
+    mark->block = self->tail;
+    mark->nevents = self->tail_nevents;
+}
+
+void
+picotm_log_truncate(struct picotm_log* self,
+                    const struct picotm_log_mark* mark)
 {
-    self->eventtablen = 0;
+    assert(self);
+    assert(mark);
+
+    /* Keep all blocks after the mark for later use. */
+    self->tail = mark->block;
+    self->tail_nevents = mark->nevents;
+}
+
+static struct picotm_log_block*
+picotm_log_next_block(struct picotm_log* self, struct picotm_error* error)
+{
+    assert(self);
+
+    struct picotm_log_block* next = self->tail ? self->tail->next
+                                               : self->head;
+    if (next) {
+        return next; /* re-use block from previous transaction */
+    }
+
+    next = malloc(sizeof(*next));
+    if (!next) {
+        picotm_error_set_errno(error, errno);
+        return nullptr;
+    }
+    next->next = nullptr;
+    next->prev = self->tail;
+
+    if (self->tail) {
+        self->tail->next = next;
+    } else {
+        self->head = next;
+    }
+
+    return next;
 }
 
 static struct picotm_event*
@@ -69,33 +122,27 @@ picotm_log_end_alloc(struct picotm_log* self, struct picotm_error* error)
 {
     assert(self);
 
-    size_t neweventtabsiz = self->eventtablen + 1;
-
-    if (neweventtabsiz <= self->eventtabsiz) {
-        goto out;
+    if (self->tail && (self->tail_nevents < PICOTM_LOG_BLOCK_NEVENTS)) {
+        return self->tail->event + self->tail_nevents;
     }
 
-    void* tmp = tabresize(self->eventtab,
-                          self->eventtabsiz, neweventtabsiz,
-                          sizeof(self->eventtab[0]),
-                          error);
+    struct picotm_log_block* next = picotm_log_next_block(self, error);
     if (picotm_error_is_set(error)) {
         return nullptr;
     }
-    self->eventtab = tmp;
-    self->eventtabsiz = neweventtabsiz;
+    self->tail = next;
+    self->tail_nevents = 0;
 
-out:
-    return (struct picotm_event*)picotm_log_end(self);
+    return self->tail->event;
 }
 
 static void
 picotm_log_end_seal(struct picotm_log* self, const struct picotm_event* event)
 {
     assert(self);
-    assert(event == picotm_log_end(self));
+    assert(event == self->tail->event + self->tail_nevents);
 
-    ++self->eventtablen;
+    ++self->tail_nevents;
 }
 
 void
@@ -110,7 +157,138 @@ picotm_log_append(struct picotm_log* self, const struct picotm_event* event,
         return;
     }
 
-    memcpy(end, event, sizeof(*event));
+    *end = *event;
 
     picotm_log_end_seal(self, end);
 }
+
+void
+picotm_log_append_n(struct picotm_log* self, uint16_t module, size_t nevents,
+                    const uint16_t head[], const uintptr_t tail[],
+                    struct picotm_error* error)
+{
+    assert(self);
+    assert(!nevents || head);
+    assert(!nevents || tail);
+
+    struct picotm_log_block* old_tail = self->tail;
+    size_t old_tail_nevents = self->tail_nevents;
+
+    while (nevents) {
+
+        if (!self->tail || (self->tail_nevents == PICOTM_LOG_BLOCK_NEVENTS)) {
+            struct picotm_log_block* next = picotm_log_next_block(self, error);
+            if (picotm_error_is_set(error)) {
+                goto err_picotm_log_next_block;
+            }
+            self->tail = next;
+            self->tail_nevents = 0;
+        }
+
+        size_t n = PICOTM_LOG_BLOCK_NEVENTS - self->tail_nevents;
+        if (n > nevents) {
+            n = nevents;
+        }
+
+        struct picotm_event* beg = self->tail->event + self->tail_nevents;
+        const struct picotm_event* end = beg + n;
+
+        for (; beg < end; ++beg, ++head, ++tail) {
+            beg->module = module;
+            beg->head = *head;
+            beg->tail = *tail;
+        }
+
+        self->tail_nevents += n;
+        nevents -= n;
+    }
+
+    return;
+
+err_picotm_log_next_block:
+    /* Newly allocated blocks stay in the log for later use. */
+    self->tail = old_tail;
+    self->tail_nevents = old_tail_nevents;
+}
+
+static size_t
+block_nevents(const struct picotm_log* self,
+              const struct picotm_log_block* block)
+{
+    if (block == self->tail) {
+        return self->tail_nevents;
+    }
+    return PICOTM_LOG_BLOCK_NEVENTS;
+}
+
+void
+picotm_log_foreach_block1(struct picotm_log* self, void* data,
+                          void (*call)(const struct picotm_event*,
+                                       const struct picotm_event*, void*,
+                                       struct picotm_error*),
+                          struct picotm_error* error)
+{
+    assert(self);
+    assert(call);
+
+    if (!self->tail) {
+        return;
+    }
+
+    for (const struct picotm_log_block* block = self->head;
+                                        block != self->tail->next;
+                                        block = block->next) {
+        call(block->event, block->event + block_nevents(self, block),
+             data, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
+void
+picotm_log_rev_foreach_block1(struct picotm_log* self, void* data,
+                              void (*call)(const struct picotm_event*,
+                                           const struct picotm_event*, void*,
+                                           struct picotm_error*),
+                              struct picotm_error* error)
+{
+    assert(self);
+    assert(call);
+
+    for (const struct picotm_log_block* block = self->tail;
+                                        block;
+                                        block = block->prev) {
+        call(block->event, block->event + block_nevents(self, block),
+             data, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
+void
+picotm_log_rev_foreach_block1_after(
+    struct picotm_log* self, const struct picotm_log_mark* mark, void* data,
+    void (*call)(const struct picotm_event*, const struct picotm_event*,
+                 void*, struct picotm_error*),
+    struct picotm_error* error)
+{
+    assert(self);
+    assert(mark);
+    assert(call);
+
+    for (const struct picotm_log_block* block = self->tail;
+                                        block;
+                                        block = block->prev) {
+        size_t beg = (block == mark->block) ? mark->nevents : 0;
+        call(block->event + beg, block->event + block_nevents(self, block),
+             data, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        if (block == mark->block) {
+            return;
+        }
+    }
+}
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "picotm_event.h"
 
 /**
  * \cond impl || lib_impl
@@ -29,21 +32,58 @@
  */
 
 struct picotm_error;
-struct picotm_event;
+
+/**
+ * \brief The number of events stored in each block of the log.
+ */
+#define PICOTM_LOG_BLOCK_NEVENTS    (256)
+
+/**
+ * \brief A fixed-size block of events in a transaction's log.
+ *
+ * The log stores events in a doubly-linked list of blocks. Appending
+ * an event never moves existing events and blocks stay allocated
+ * across transactions, so the log's capacity is retained for the
+ * thread's next transaction.
+ */
+struct picotm_log_block {
+
+    /** The next block in the log. */
+    struct picotm_log_block* next;
+
+    /** The previous block in the log. */
+    struct picotm_log_block* prev;
+
+    /** The block's events. */
+    struct picotm_event event[PICOTM_LOG_BLOCK_NEVENTS];
+};
 
 /**
  * \brief The log holds the events of a transaction.
  */
 struct picotm_log {
 
-    /** Table of transaction events. */
-    struct picotm_event* eventtab;
+    /** The first block of the log. */
+    struct picotm_log_block* head;
 
-    /** Valid data bytes in the transaction log. */
-    size_t eventtablen;
+    /** The block that receives newly appended events. Blocks after
+     * the tail block are allocated, but currently unused. */
+    struct picotm_log_block* tail;
 
-    /** Allocation size of the transaction log. */
-    size_t eventtabsiz;
+    /** Number of valid events in the tail block. */
+    size_t tail_nevents;
+};
+
+/**
+ * \brief A position in a transaction's log.
+ */
+struct picotm_log_mark {
+
+    /** The tail block at the position. */
+    struct picotm_log_block* block;
+
+    /** Number of valid events in the tail block at the position. */
+    size_t nevents;
 };
 
 /**
@@ -59,20 +99,12 @@ void
 picotm_log_uninit(struct picotm_log* self);
 
 /**
- * \brief Returns the first event in an event log.
+ * \brief Tests if an event log is empty.
  * \param   self    The event log.
- * \returns The event log's first event.
+ * \returns True if the event log contains no events, false otherwise.
  */
-struct picotm_event*
-picotm_log_begin(struct picotm_log* self);
-
-/**
- * \brief Returns the terminal event at the end of an event log.
- * \param   self    The event log.
- * \returns The event log's terminal event.
- */
-const struct picotm_event*
-picotm_log_end(struct picotm_log* self);
+bool
+picotm_log_is_empty(const struct picotm_log* self);
 
 /**
  * \brief Appends an event to an event log.
@@ -84,9 +116,97 @@ void
 picotm_log_append(struct picotm_log* self, const struct picotm_event* event,
            struct picotm_error* error);
 
+/**
+ * \brief Appends multiple events of the same module to an event log.
+ * \param       self    The event log.
+ * \param       module  The events' module.
+ * \param       nevents The number of events to append.
+ * \param       head    An array of nevents head values.
+ * \param       tail    An array of nevents tail values.
+ * \param[out]  error   Returns an error to the caller.
+ *
+ * On errors, none of the events has been appended to the log.
+ */
+void
+picotm_log_append_n(struct picotm_log* self, uint16_t module, size_t nevents,
+                    const uint16_t head[], const uintptr_t tail[],
+                    struct picotm_error* error);
+
 /**
  * \brief Removes all events from an event log.
  * \param   self    The event log.
+ *
+ * The log's blocks remain allocated for later use.
  */
 void
 picotm_log_clear(struct picotm_log* self);
+
+/**
+ * \brief Returns the current end of an event log.
+ * \param       self    The event log.
+ * \param[out]  mark    Returns the log's current end.
+ */
+void
+picotm_log_get_mark(const struct picotm_log* self,
+                    struct picotm_log_mark* mark);
+
+/**
+ * \brief Removes all events after a mark from an event log.
+ * \param   self    The event log.
+ * \param   mark    A mark that was returned for the event log by
+ *                  picotm_log_get_mark().
+ *
+ * The log's blocks remain allocated for later use.
+ */
+void
+picotm_log_truncate(struct picotm_log* self,
+                    const struct picotm_log_mark* mark);
+
+/**
+ * \brief Invokes a call-back function on each block of events in an
+ *        event log.
+ * \param       self    The event log.
+ * \param       data    The call-back function's data argument.
+ * \param       call    The call-back function. It receives the
+ *                      block's first and terminal event.
+ * \param[out]  error   Returns an error to the caller.
+ */
+void
+picotm_log_foreach_block1(struct picotm_log* self, void* data,
+                          void (*call)(const struct picotm_event*,
+                                       const struct picotm_event*, void*,
+                                       struct picotm_error*),
+                          struct picotm_error* error);
+
+/**
+ * \brief Invokes a call-back function on each block of events in an
+ *        event log in reversed order.
+ * \param       self    The event log.
+ * \param       data    The call-back function's data argument.
+ * \param       call    The call-back function. It receives the
+ *                      block's first and terminal event.
+ * \param[out]  error   Returns an error to the caller.
+ */
+void
+picotm_log_rev_foreach_block1(struct picotm_log* self, void* data,
+                              void (*call)(const struct picotm_event*,
+                                           const struct picotm_event*, void*,
+                                           struct picotm_error*),
+                              struct picotm_error* error);
+
+/**
+ * \brief Invokes a call-back function on each block of events after
+ *        a mark in an event log in reversed order.
+ * \param       self    The event log.
+ * \param       mark    The mark.
+ * \param       data    The call-back function's data argument.
+ * \param       call    The call-back function. It receives the
+ *                      block's first and terminal event.
+ * \param[out]  error   Returns an error to the caller.
+ */
+void
+picotm_log_rev_foreach_block1_after(
+    struct picotm_log* self, const struct picotm_log_mark* mark, void* data,
+    void (*call)(const struct picotm_event*, const struct picotm_event*,
+                 void*, struct picotm_error*),
+    struct picotm_error* error);
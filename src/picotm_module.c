@@ -19,6 +19,7 @@
 
 #include "picotm_module.h"
 #include <assert.h>
+#include "picotm/picotm-error.h"
 #include "picotm/picotm-module.h"
 
 void
@@ -131,6 +132,102 @@ picotm_module_undo_event(const struct picotm_module* self,
     self->ops->undo_event(head, tail, self->data, error);
 }
 
+void
+picotm_module_apply_events(const struct picotm_module* self,
+                           const struct picotm_event* event, size_t nevents,
+                           struct picotm_error* error)
+{
+    assert(self);
+    assert(self->ops);
+
+    if (self->ops->apply_events) {
+        self->ops->apply_events(event, nevents, self->data, error);
+        return;
+    }
+
+    if (!self->ops->apply_event) {
+        return;
+    }
+
+    const struct picotm_event* end = event + nevents;
+
+    for (; event < end; ++event) {
+        self->ops->apply_event(event->head, event->tail, self->data, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
+void
+picotm_module_undo_events(const struct picotm_module* self,
+                          const struct picotm_event* event, size_t nevents,
+                          struct picotm_error* error)
+{
+    assert(self);
+    assert(self->ops);
+
+    if (self->ops->undo_events) {
+        self->ops->undo_events(event, nevents, self->data, error);
+        return;
+    }
+
+    if (!self->ops->undo_event) {
+        return;
+    }
+
+    const struct picotm_event* pos = event + nevents;
+
+    while (event < pos) {
+        --pos;
+        self->ops->undo_event(pos->head, pos->tail, self->data, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+}
+
+uintptr_t
+picotm_module_savepoint(const struct picotm_module* self,
+                        struct picotm_error* error)
+{
+    assert(self);
+    assert(self->ops);
+
+    if (!self->ops->savepoint) {
+        return 0;
+    }
+    return self->ops->savepoint(self->data, error);
+}
+
+void
+picotm_module_rollback_to_savepoint(const struct picotm_module* self,
+                                    uintptr_t mark,
+                                    struct picotm_error* error)
+{
+    assert(self);
+    assert(self->ops);
+
+    if (!self->ops->rollback_to_savepoint) {
+        return;
+    }
+    self->ops->rollback_to_savepoint(mark, self->data, error);
+}
+
+void
+picotm_module_release_savepoint(const struct picotm_module* self,
+                                uintptr_t mark,
+                                struct picotm_error* error)
+{
+    assert(self);
+    assert(self->ops);
+
+    if (!self->ops->release_savepoint) {
+        return;
+    }
+    self->ops->release_savepoint(mark, self->data, error);
+}
+
 void
 picotm_module_finish(const struct picotm_module* self,
                      struct picotm_error* error)
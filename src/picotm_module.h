@@ -31,6 +31,7 @@
  */
 
 struct picotm_error;
+struct picotm_event;
 struct picotm_module_ops;
 
 struct picotm_module {
@@ -75,6 +76,30 @@ picotm_module_undo_event(const struct picotm_module* self,
                          uint16_t head, uintptr_t tail,
                          struct picotm_error* error);
 
+void
+picotm_module_apply_events(const struct picotm_module* self,
+                           const struct picotm_event* event, size_t nevents,
+                           struct picotm_error* error);
+
+void
+picotm_module_undo_events(const struct picotm_module* self,
+                          const struct picotm_event* event, size_t nevents,
+                          struct picotm_error* error);
+
+uintptr_t
+picotm_module_savepoint(const struct picotm_module* self,
+                        struct picotm_error* error);
+
+void
+picotm_module_rollback_to_savepoint(const struct picotm_module* self,
+                                    uintptr_t mark,
+                                    struct picotm_error* error);
+
+void
+picotm_module_release_savepoint(const struct picotm_module* self,
+                                uintptr_t mark,
+                                struct picotm_error* error);
+
 void
 picotm_module_finish(const struct picotm_module* self,
                      struct picotm_error* error);
@@ -63,6 +63,23 @@ picotm_os_get_timespec(struct timespec* self,
 #endif
 }
 
+void
+picotm_os_get_coarse_timespec(struct timespec* self,
+                              struct picotm_error* error)
+{
+#if defined(CLOCK_MONOTONIC_COARSE)
+    /* On Linux, the coarse clock is read from the vDSO without
+     * accessing the clock hardware. */
+    int res = clock_gettime(CLOCK_MONOTONIC_COARSE, self);
+    if (res < 0) {
+        picotm_error_set_errno(error, errno);
+        return;
+    }
+#else
+    picotm_os_get_timespec(self, error);
+#endif
+}
+
 void
 picotm_os_add_timespec(struct timespec* lhs,
                  const struct timespec* rhs)
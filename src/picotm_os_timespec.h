@@ -54,6 +54,20 @@ void
 picotm_os_get_timespec(struct timespec* self,
                        struct picotm_error* error);
 
+/**
+ * \brief Retrieves the current time from a fast, low-resolution clock.
+ * \param[out] self The retrieved time.
+ * \param[out] error Returns an error to the caller.
+ *
+ * The time returned by this function is only comparable to other values
+ * returned by this function. Its granularity can be in the range of
+ * milliseconds. It shall be used for ordering and coarse aging, but
+ * not for timeouts.
+ */
+void
+picotm_os_get_coarse_timespec(struct timespec* self,
+                              struct picotm_error* error);
+
 /**
  * \brief Adds two timespec values in place.
  * \param[in,out] lhs Left-hand-side operator and result.
@@ -0,0 +1,401 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "picotm_profiler.h"
+#include "picotm/picotm-lib-spinlock.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Profiler state
+ */
+
+/** \brief Profiling has not been enabled or disabled yet. */
+#define PROFILER_UNSET  (-1)
+
+static atomic_int s_enabled = PROFILER_UNSET;
+
+/* The number of hotspots reported at exit. */
+static size_t s_nhotspots_at_exit;
+
+static void
+print_hotspots_at_exit(void)
+{
+    picotm_profiler_print_hotspots(stderr, s_nhotspots_at_exit);
+}
+
+static bool
+enabled_from_env(void)
+{
+    const char* value = getenv("PICOTM_CONFLICT_PROFILE");
+    if (!value) {
+        return false;
+    }
+
+    /* The value is the number of hotspots to report at exit. */
+    char* end;
+    unsigned long n = strtoul(value, &end, 0);
+    if (*end || !n) {
+        return false;
+    }
+
+    s_nhotspots_at_exit = n;
+
+    if (atexit(print_hotspots_at_exit)) {
+        return false;
+    }
+    return true;
+}
+
+bool
+picotm_profiler_is_enabled()
+{
+    int enabled = atomic_load_explicit(&s_enabled, memory_order_acquire);
+    if (enabled != PROFILER_UNSET) {
+        return enabled;
+    }
+
+    static struct picotm_spinlock s_env_lock = PICOTM_SPINLOCK_INITIALIZER;
+
+    /* Serialize reading the environment to install the exit
+     * handler only once. */
+    picotm_spinlock_lock(&s_env_lock);
+
+    enabled = atomic_load_explicit(&s_enabled, memory_order_acquire);
+    if (enabled == PROFILER_UNSET) {
+        enabled = enabled_from_env();
+        atomic_store_explicit(&s_enabled, enabled, memory_order_release);
+    }
+
+    picotm_spinlock_unlock(&s_env_lock);
+
+    return enabled;
+}
+
+void
+picotm_profiler_set_enabled(bool enabled)
+{
+    /* Read the environment first, so it cannot override the
+     * new setting later. */
+    picotm_profiler_is_enabled();
+
+    atomic_store_explicit(&s_enabled, enabled, memory_order_release);
+}
+
+/*
+ * Lock ranges
+ *
+ * Ranges are only recorded while profiling is enabled, so registering
+ * objects costs nothing otherwise. The ranges don't overlap and are
+ * sorted by their beginning. Look-ups and removals use binary search.
+ */
+
+struct lock_range {
+    const void* beg;
+    const void* end;
+    picotm_describe_lock_function describe;
+    const void* data;
+};
+
+static struct picotm_spinlock s_range_lock = PICOTM_SPINLOCK_INITIALIZER;
+static struct lock_range* s_range;
+static size_t s_nranges;
+static size_t s_nranges_allocated;
+
+/* True once a range has been recorded. Objects have to unregister
+ * their ranges even after profiling has been disabled, but without
+ * any recorded ranges, there's nothing to look up. */
+static atomic_bool s_has_ranges;
+
+/* Returns the index of the first range that begins after 'addr'. Call
+ * with 's_range_lock' held. */
+static size_t
+upper_bound(const void* addr)
+{
+    size_t beg = 0;
+    size_t end = s_nranges;
+
+    while (beg < end) {
+        size_t mid = beg + (end - beg) / 2;
+        if (s_range[mid].beg <= addr) {
+            beg = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+
+    return beg;
+}
+
+void
+picotm_profiler_register_locks(const void* beg, const void* end,
+                               picotm_describe_lock_function describe,
+                               const void* data)
+{
+    assert(beg <= end);
+    assert(describe);
+
+    if (!picotm_profiler_is_enabled()) {
+        return;
+    }
+
+    picotm_spinlock_lock(&s_range_lock);
+
+    if (s_nranges == s_nranges_allocated) {
+        size_t nranges_allocated = s_nranges_allocated ?
+                                   2 * s_nranges_allocated : 64;
+        struct lock_range* range = realloc(s_range,
+                                           nranges_allocated *
+                                           sizeof(*range));
+        if (!range) {
+            /* The locks will be reported without description. */
+            goto out;
+        }
+        s_range = range;
+        s_nranges_allocated = nranges_allocated;
+    }
+
+    size_t index = upper_bound(beg);
+
+    struct lock_range* range = s_range + index;
+    memmove(range + 1, range, (s_nranges - index) * sizeof(*range));
+
+    range->beg = beg;
+    range->end = end;
+    range->describe = describe;
+    range->data = data;
+
+    ++s_nranges;
+
+    atomic_store_explicit(&s_has_ranges, true, memory_order_release);
+
+out:
+    picotm_spinlock_unlock(&s_range_lock);
+}
+
+void
+picotm_profiler_unregister_locks(const void* beg)
+{
+    /* A range is recorded before its object becomes visible to the
+     * thread that unregisters it, so we'll see the flag if needed. */
+    if (!atomic_load_explicit(&s_has_ranges, memory_order_acquire)) {
+        return;
+    }
+
+    picotm_spinlock_lock(&s_range_lock);
+
+    size_t index = upper_bound(beg);
+
+    if (index && (s_range[index - 1].beg == beg)) {
+        struct lock_range* range = s_range + index - 1;
+        memmove(range, range + 1, (s_nranges - index) * sizeof(*range));
+        --s_nranges;
+    }
+
+    picotm_spinlock_unlock(&s_range_lock);
+}
+
+static void
+describe_lock(const struct picotm_rwlock* lock, char* buf, size_t siz)
+{
+    const void* addr = lock;
+
+    picotm_spinlock_lock(&s_range_lock);
+
+    size_t index = upper_bound(addr);
+
+    if (index && (addr < s_range[index - 1].end)) {
+        const struct lock_range* range = s_range + index - 1;
+        range->describe(lock, range->data, buf, siz);
+    } else {
+        snprintf(buf, siz, "unknown lock %p", addr);
+    }
+
+    picotm_spinlock_unlock(&s_range_lock);
+}
+
+/*
+ * Hotspot table
+ */
+
+#define HOTSPOT_TABLE_NENTRIES  (1024)
+
+/* The number of entries probed before a conflict is dropped. */
+static const size_t NPROBES = 16;
+
+struct hotspot {
+    atomic_uintptr_t lock;
+    atomic_ulong nconflicts;
+    atomic_bool has_description;
+    char description[PICOTM_CONFLICT_HOTSPOT_DESCRIPTION_SIZE];
+};
+
+static struct hotspot s_hotspot[HOTSPOT_TABLE_NENTRIES];
+
+/* Conflicts that didn't fit into the hotspot table. */
+static atomic_ulong s_ndropped;
+
+static size_t
+hotspot_hash(uintptr_t lock)
+{
+    /* Locks are often located in arrays; mix in the higher bits. */
+    lock ^= lock >> 9;
+    lock ^= lock >> 17;
+
+    return lock % HOTSPOT_TABLE_NENTRIES;
+}
+
+void
+picotm_profiler_add_conflict(const struct picotm_rwlock* lock)
+{
+    if (!lock) {
+        return; /* conflicts without lock are not profiled */
+    }
+
+    uintptr_t key = (uintptr_t)lock;
+    size_t index = hotspot_hash(key);
+
+    for (size_t i = 0; i < NPROBES; ++i) {
+
+        struct hotspot* hotspot =
+            s_hotspot + ((index + i) % HOTSPOT_TABLE_NENTRIES);
+
+        uintptr_t expected = 0;
+        bool succ = atomic_compare_exchange_strong_explicit(
+            &hotspot->lock, &expected, key,
+            memory_order_acq_rel, memory_order_acquire);
+        if (succ) {
+            /* We took the empty entry; describe the lock. The
+             * description remains with the entry, even if the
+             * lock's memory is reused later. */
+            describe_lock(lock, hotspot->description,
+                          sizeof(hotspot->description));
+            atomic_store_explicit(&hotspot->has_description, true,
+                                  memory_order_release);
+        } else if (expected != key) {
+            continue;
+        }
+
+        atomic_fetch_add_explicit(&hotspot->nconflicts, 1,
+                                  memory_order_relaxed);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&s_ndropped, 1, memory_order_relaxed);
+}
+
+static int
+compare_hotspots(const void* lhs, const void* rhs)
+{
+    const struct picotm_conflict_hotspot* lhs_hotspot = lhs;
+    const struct picotm_conflict_hotspot* rhs_hotspot = rhs;
+
+    return (lhs_hotspot->nconflicts < rhs_hotspot->nconflicts) -
+           (lhs_hotspot->nconflicts > rhs_hotspot->nconflicts);
+}
+
+size_t
+picotm_profiler_get_hotspots(struct picotm_conflict_hotspot* hotspot,
+                             size_t n)
+{
+    assert(hotspot || !n);
+
+    if (!n) {
+        return 0;
+    }
+
+    struct picotm_conflict_hotspot* all = malloc(sizeof(*all) *
+                                                 HOTSPOT_TABLE_NENTRIES);
+    if (!all) {
+        return 0;
+    }
+
+    size_t nall = 0;
+
+    const struct hotspot* beg = s_hotspot;
+    const struct hotspot* end = s_hotspot + HOTSPOT_TABLE_NENTRIES;
+
+    for (; beg < end; ++beg) {
+        uintptr_t lock = atomic_load_explicit(&beg->lock,
+                                              memory_order_acquire);
+        if (!lock) {
+            continue;
+        }
+
+        struct picotm_conflict_hotspot* entry = all + nall++;
+
+        entry->lock = (const struct picotm_rwlock*)lock;
+        entry->nconflicts = atomic_load_explicit(&beg->nconflicts,
+                                                 memory_order_relaxed);
+
+        bool has_description = atomic_load_explicit(&beg->has_description,
+                                                    memory_order_acquire);
+        if (has_description) {
+            memcpy(entry->description, beg->description,
+                   sizeof(entry->description));
+        } else {
+            entry->description[0] = '\0';
+        }
+    }
+
+    qsort(all, nall, sizeof(*all), compare_hotspots);
+
+    if (n > nall) {
+        n = nall;
+    }
+    memcpy(hotspot, all, n * sizeof(*hotspot));
+
+    free(all);
+
+    return n;
+}
+
+void
+picotm_profiler_print_hotspots(FILE* stream, size_t n)
+{
+    assert(stream);
+
+    struct picotm_conflict_hotspot* hotspot = malloc(sizeof(*hotspot) * n);
+    if (!hotspot && n) {
+        return;
+    }
+
+    size_t nhotspots = picotm_profiler_get_hotspots(hotspot, n);
+
+    fprintf(stream, "picotm conflict hotspots (top %zu)\n", n);
+    fprintf(stream, "%-6s %-12s %-18s %s\n",
+            "rank", "conflicts", "lock", "description");
+
+    for (size_t i = 0; i < nhotspots; ++i) {
+        fprintf(stream, "%-6zu %-12lu %-18p %s\n",
+                i + 1, hotspot[i].nconflicts, (const void*)hotspot[i].lock,
+                hotspot[i].description);
+    }
+
+    unsigned long ndropped = atomic_load_explicit(&s_ndropped,
+                                                  memory_order_relaxed);
+    if (ndropped) {
+        fprintf(stream, "%lu conflicts not recorded\n", ndropped);
+    }
+
+    free(hotspot);
+}
@@ -0,0 +1,94 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "picotm/picotm.h"
+#include "picotm/picotm-module.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * \cond impl || lib_impl
+ * \ingroup lib_impl
+ * \file
+ * \endcond
+ */
+
+/**
+ * \brief Returns true if conflict profiling is enabled.
+ *
+ * Unless profiling has been enabled or disabled before, the first
+ * call reads the environment variable `PICOTM_CONFLICT_PROFILE`.
+ */
+bool
+picotm_profiler_is_enabled(void);
+
+/**
+ * \brief Enables or disables conflict profiling.
+ * \param enabled True to enable profiling, false to disable it.
+ */
+void
+picotm_profiler_set_enabled(bool enabled);
+
+/**
+ * \brief Registers a range of locks with a describe function. The
+ *        range is only recorded while profiling is enabled.
+ * \param beg The beginning of the range.
+ * \param end The end of the range.
+ * \param describe The describe function.
+ * \param data The data argument for the describe function.
+ */
+void
+picotm_profiler_register_locks(const void* beg, const void* end,
+                               picotm_describe_lock_function describe,
+                               const void* data);
+
+/**
+ * \brief Unregisters a range of locks.
+ * \param beg The beginning of the range.
+ */
+void
+picotm_profiler_unregister_locks(const void* beg);
+
+/**
+ * \brief Accounts a conflict on a lock.
+ * \param lock The conflicting lock.
+ */
+void
+picotm_profiler_add_conflict(const struct picotm_rwlock* lock);
+
+/**
+ * \brief Returns the locks with the most conflicts.
+ * \param[out] hotspot Returns the hotspots, sorted by number of conflicts.
+ * \param n The maximum number of hotspots to return.
+ * \returns The number of returned hotspots.
+ */
+size_t
+picotm_profiler_get_hotspots(struct picotm_conflict_hotspot* hotspot,
+                             size_t n);
+
+/**
+ * \brief Prints a report of the locks with the most conflicts.
+ * \param stream The output stream.
+ * \param n The maximum number of reported locks.
+ */
+void
+picotm_profiler_print_hotspots(FILE* stream, size_t n);
@@ -0,0 +1,146 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "picotm_site.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "picotm/picotm-lib-array.h"
+
+/* The retry limit of a site without conflicts. A transaction that
+ * reaches the limit switches to prioritized mode. */
+static const unsigned long MIN_NRETRIES_LIMIT = 10;
+
+/* The upper bound of the retry limit for sites with high conflict
+ * rates. */
+static const unsigned long MAX_NRETRIES_LIMIT = 100;
+
+/* The number of consecutive irrevocable commits after which a site
+ * starts its transactions in irrevocable mode. */
+static const unsigned long NIRREVOCABLE_THRESHOLD = 4;
+
+/* An irrevocable site starts every n-th transaction in revocable
+ * mode to test if it still requires irrevocability. */
+static const unsigned long NTXS_PROBE_INTERVAL = 64;
+
+/* The average number of retries is stored in 1/16th. */
+static const unsigned long AVG_NRETRIES_SHIFT = 4;
+
+void
+picotm_site_init(struct picotm_site* self, const void* addr)
+{
+    assert(self);
+
+    self->addr = addr;
+    self->ntxs = 0;
+    self->nirrevocable = 0;
+    self->avg_nretries = 0;
+}
+
+bool
+picotm_site_begin(struct picotm_site* self)
+{
+    assert(self);
+
+    ++self->ntxs;
+
+    if (self->nirrevocable < NIRREVOCABLE_THRESHOLD) {
+        return false;
+    }
+    return !!(self->ntxs % NTXS_PROBE_INTERVAL);
+}
+
+unsigned long
+picotm_site_get_nretries_limit(const struct picotm_site* self)
+{
+    assert(self);
+
+    /* Sites with high conflict rates retry more often before
+     * switching to prioritized mode. Prioritized transactions
+     * serialize among each other, so escalating a hot site
+     * would serialize the whole process. */
+    unsigned long limit = MIN_NRETRIES_LIMIT +
+        ((2 * self->avg_nretries) >> AVG_NRETRIES_SHIFT);
+
+    if (limit > MAX_NRETRIES_LIMIT) {
+        return MAX_NRETRIES_LIMIT;
+    }
+    return limit;
+}
+
+void
+picotm_site_commit(struct picotm_site* self, unsigned long nretries,
+                   bool is_irrevocable)
+{
+    assert(self);
+
+    if (is_irrevocable) {
+        if (self->nirrevocable < NIRREVOCABLE_THRESHOLD) {
+            ++self->nirrevocable;
+        }
+    } else {
+        self->nirrevocable = 0;
+    }
+
+    if (nretries > MAX_NRETRIES_LIMIT) {
+        nretries = MAX_NRETRIES_LIMIT;
+    }
+
+    /* Exponential moving average with a weight of 1/8. */
+    self->avg_nretries = self->avg_nretries - (self->avg_nretries >> 3) +
+        ((nretries << AVG_NRETRIES_SHIFT) >> 3);
+}
+
+void
+picotm_site_table_init(struct picotm_site_table* self)
+{
+    assert(self);
+
+    struct picotm_site* beg = picotm_arraybeg(self->site);
+    const struct picotm_site* end = picotm_arrayend(self->site);
+
+    for (; beg < end; ++beg) {
+        picotm_site_init(beg, nullptr);
+    }
+}
+
+static size_t
+site_hash(const void* addr)
+{
+    uintptr_t hash = (uintptr_t)addr;
+
+    /* Call sites are close to each other; mix in the higher bits. */
+    hash ^= hash >> 6;
+    hash ^= hash >> 12;
+
+    return hash % PICOTM_SITE_TABLE_NENTRIES;
+}
+
+struct picotm_site*
+picotm_site_table_lookup(struct picotm_site_table* self, const void* addr)
+{
+    assert(self);
+
+    struct picotm_site* site = self->site + site_hash(addr);
+
+    if (site->addr != addr) {
+        picotm_site_init(site, addr);
+    }
+    return site;
+}
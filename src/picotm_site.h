@@ -0,0 +1,116 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * \cond impl || lib_impl
+ * \ingroup lib_impl
+ * \file
+ * \endcond
+ */
+
+/**
+ * \brief Per-call-site statistics of a transaction.
+ *
+ * Each thread keeps statistics for the call sites of `picotm_begin`
+ * it executes. The statistics select the initial mode of a new
+ * transaction and the number of retries before a transaction
+ * switches to prioritized mode.
+ */
+struct picotm_site {
+    /** The site's address, or nullptr if the entry is unused. */
+    const void* addr;
+    /** The number of transactions started at the site. */
+    unsigned long ntxs;
+    /** The number of consecutive irrevocable commits. */
+    unsigned long nirrevocable;
+    /** The average number of retries per transaction in 1/16th. */
+    unsigned long avg_nretries;
+};
+
+/**
+ * \brief Initializes a site entry.
+ * \param self The site entry.
+ * \param addr The site's address.
+ */
+void
+picotm_site_init(struct picotm_site* self, const void* addr);
+
+/**
+ * \brief Starts a transaction at a site.
+ * \param self The site entry.
+ * \returns True if the transaction should start in irrevocable mode,
+ *          or false otherwise.
+ */
+bool
+picotm_site_begin(struct picotm_site* self);
+
+/**
+ * \brief Returns the site's maximum number of retries before a
+ *        transaction switches to prioritized mode.
+ * \param self The site entry.
+ * \returns The site's retry limit.
+ */
+unsigned long
+picotm_site_get_nretries_limit(const struct picotm_site* self);
+
+/**
+ * \brief Accounts a committed transaction to a site.
+ * \param self The site entry.
+ * \param nretries The transaction's number of retries.
+ * \param is_irrevocable True if the transaction committed in
+ *                       irrevocable mode, or false otherwise.
+ */
+void
+picotm_site_commit(struct picotm_site* self, unsigned long nretries,
+                   bool is_irrevocable);
+
+/**
+ * \brief The number of entries in a site table.
+ */
+#define PICOTM_SITE_TABLE_NENTRIES  (64)
+
+/**
+ * \brief A table of per-site statistics.
+ *
+ * The table is direct-mapped. If two call sites map to the same
+ * entry, the most recent one evicts the other one.
+ */
+struct picotm_site_table {
+    struct picotm_site site[PICOTM_SITE_TABLE_NENTRIES];
+};
+
+/**
+ * \brief Initializes a site table.
+ * \param self The site table.
+ */
+void
+picotm_site_table_init(struct picotm_site_table* self);
+
+/**
+ * \brief Looks up the entry for a site's address.
+ * \param self The site table.
+ * \param addr The site's address.
+ * \returns The site entry for the given address.
+ */
+struct picotm_site*
+picotm_site_table_lookup(struct picotm_site_table* self, const void* addr);
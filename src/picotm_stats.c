@@ -0,0 +1,214 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "picotm_stats.h"
+#include "picotm/picotm-lib-spinlock.h"
+#include "picotm/picotm.h"
+#include <assert.h>
+#include <time.h>
+
+/* The list of registered per-thread statistics and the accumulated
+ * statistics of terminated threads. The spinlock protects both. The
+ * state is process-wide and outlives the global state, so that
+ * statistics remain available after all threads released picotm. */
+static struct picotm_spinlock s_lock = PICOTM_SPINLOCK_INITIALIZER;
+static struct picotm_tx_stats* s_list;
+static struct picotm_stats s_retired;
+
+static void
+counter_add(atomic_ullong* counter, unsigned long long value)
+{
+    /* Only the owning thread writes the counter. */
+    atomic_store_explicit(
+        counter,
+        atomic_load_explicit(counter, memory_order_relaxed) + value,
+        memory_order_relaxed);
+}
+
+static unsigned long long
+counter_get(const atomic_ullong* counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static unsigned long long
+timespec_diff_ns(const struct timespec* beg, const struct timespec* end)
+{
+    long long ns = (end->tv_sec - beg->tv_sec) * 1000000000ll +
+                   (end->tv_nsec - beg->tv_nsec);
+
+    /* The system clock can be set backwards. */
+    if (ns < 0) {
+        return 0;
+    }
+    return ns;
+}
+
+static void
+accumulate(struct picotm_stats* stats, const struct picotm_tx_stats* tx)
+{
+    stats->ncommits += counter_get(&tx->ncommits);
+    stats->nretries += counter_get(&tx->nretries);
+
+    unsigned long long max_nretries = counter_get(&tx->max_nretries);
+    if (max_nretries > stats->max_nretries) {
+        stats->max_nretries = max_nretries;
+    }
+
+    stats->naborts_conflicting +=
+        counter_get(&tx->naborts[PICOTM_CONFLICTING - 1]);
+    stats->naborts_revocable +=
+        counter_get(&tx->naborts[PICOTM_REVOCABLE - 1]);
+    stats->naborts_error_code +=
+        counter_get(&tx->naborts[PICOTM_ERROR_CODE - 1]);
+    stats->naborts_errno +=
+        counter_get(&tx->naborts[PICOTM_ERRNO - 1]);
+    stats->naborts_kern_return_t +=
+        counter_get(&tx->naborts[PICOTM_KERN_RETURN_T - 1]);
+    stats->naborts_siginfo_t +=
+        counter_get(&tx->naborts[PICOTM_SIGINFO_T - 1]);
+    stats->naborts_restart += counter_get(&tx->naborts_restart);
+    stats->nirrevocable += counter_get(&tx->nirrevocable);
+
+    stats->wait_ns += counter_get(&tx->wait_ns);
+    stats->irrevocable_ns += counter_get(&tx->irrevocable_ns);
+}
+
+void
+picotm_tx_stats_init(struct picotm_tx_stats* self)
+{
+    assert(self);
+
+    atomic_init(&self->ncommits, 0);
+    atomic_init(&self->nretries, 0);
+    atomic_init(&self->max_nretries, 0);
+
+    atomic_ullong* beg = self->naborts;
+    const atomic_ullong* end = self->naborts + PICOTM_TX_STATS_NSTATUSES;
+    for (; beg < end; ++beg) {
+        atomic_init(beg, 0);
+    }
+
+    atomic_init(&self->naborts_restart, 0);
+    atomic_init(&self->nirrevocable, 0);
+    atomic_init(&self->wait_ns, 0);
+    atomic_init(&self->irrevocable_ns, 0);
+
+    picotm_spinlock_lock(&s_lock);
+    self->next = s_list;
+    s_list = self;
+    picotm_spinlock_unlock(&s_lock);
+}
+
+void
+picotm_tx_stats_uninit(struct picotm_tx_stats* self)
+{
+    assert(self);
+
+    picotm_spinlock_lock(&s_lock);
+
+    struct picotm_tx_stats** pos = &s_list;
+    while (*pos != self) {
+        assert(*pos);
+        pos = &(*pos)->next;
+    }
+    *pos = self->next;
+
+    accumulate(&s_retired, self);
+
+    picotm_spinlock_unlock(&s_lock);
+}
+
+void
+picotm_tx_stats_add_commit(struct picotm_tx_stats* self,
+                           unsigned long nretries)
+{
+    assert(self);
+
+    counter_add(&self->ncommits, 1);
+    counter_add(&self->nretries, nretries);
+
+    if (nretries > counter_get(&self->max_nretries)) {
+        atomic_store_explicit(&self->max_nretries, nretries,
+                              memory_order_relaxed);
+    }
+}
+
+void
+picotm_tx_stats_add_abort(struct picotm_tx_stats* self,
+                          enum picotm_error_status status)
+{
+    assert(self);
+    assert(status >= PICOTM_CONFLICTING);
+    assert(status <= PICOTM_SIGINFO_T);
+
+    counter_add(self->naborts + status - 1, 1);
+}
+
+void
+picotm_tx_stats_add_restart(struct picotm_tx_stats* self)
+{
+    assert(self);
+
+    counter_add(&self->naborts_restart, 1);
+}
+
+void
+picotm_tx_stats_add_irrevocable(struct picotm_tx_stats* self)
+{
+    assert(self);
+
+    counter_add(&self->nirrevocable, 1);
+}
+
+void
+picotm_tx_stats_add_wait_time(struct picotm_tx_stats* self,
+                              const struct timespec* beg,
+                              const struct timespec* end)
+{
+    assert(self);
+
+    counter_add(&self->wait_ns, timespec_diff_ns(beg, end));
+}
+
+void
+picotm_tx_stats_add_irrevocable_time(struct picotm_tx_stats* self,
+                                     const struct timespec* beg,
+                                     const struct timespec* end)
+{
+    assert(self);
+
+    counter_add(&self->irrevocable_ns, timespec_diff_ns(beg, end));
+}
+
+void
+picotm_stats_get(struct picotm_stats* stats)
+{
+    assert(stats);
+
+    picotm_spinlock_lock(&s_lock);
+
+    *stats = s_retired;
+
+    for (const struct picotm_tx_stats* tx = s_list; tx; tx = tx->next) {
+        accumulate(stats, tx);
+    }
+
+    picotm_spinlock_unlock(&s_lock);
+}
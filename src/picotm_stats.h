@@ -0,0 +1,160 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "picotm/picotm-error-base.h"
+#include <stdatomic.h>
+
+/**
+ * \cond impl || lib_impl
+ * \ingroup lib_impl
+ * \file
+ * \endcond
+ */
+
+struct picotm_lock_owner;
+struct picotm_stats;
+struct timespec;
+
+/**
+ * \brief The number of error statuses with separate abort counters.
+ */
+#define PICOTM_TX_STATS_NSTATUSES   (PICOTM_SIGINFO_T)
+
+/**
+ * \brief Per-thread transaction statistics.
+ *
+ * Only the owning thread writes the counters, so updates don't
+ * require atomic read-modify-write operations. Other threads read
+ * the counters when they aggregate statistics in picotm_stats_get().
+ */
+struct picotm_tx_stats {
+    /** The next entry in the list of registered statistics. */
+    struct picotm_tx_stats* next;
+
+    /** The number of committed transactions. */
+    atomic_ullong ncommits;
+    /** The number of retries of all committed transactions. */
+    atomic_ullong nretries;
+    /** The largest number of retries of a committed transaction. */
+    atomic_ullong max_nretries;
+    /** The number of aborts for each error status. */
+    atomic_ullong naborts[PICOTM_TX_STATS_NSTATUSES];
+    /** The number of aborts from picotm_restart(). */
+    atomic_ullong naborts_restart;
+    /** The number of escalations to irrevocable mode. */
+    atomic_ullong nirrevocable;
+    /** The time spent waiting for locks in nanoseconds. */
+    atomic_ullong wait_ns;
+    /** The time spent in irrevocable mode in nanoseconds. */
+    atomic_ullong irrevocable_ns;
+};
+
+/**
+ * \brief Initializes and registers per-thread statistics.
+ * \param self The statistics.
+ */
+void
+picotm_tx_stats_init(struct picotm_tx_stats* self);
+
+/**
+ * \brief Unregisters per-thread statistics.
+ * \param self The statistics.
+ *
+ * The counters are added to the process-wide statistics
+ * of terminated threads.
+ */
+void
+picotm_tx_stats_uninit(struct picotm_tx_stats* self);
+
+/**
+ * \brief Accounts a committed transaction.
+ * \param self The statistics.
+ * \param nretries The transaction's number of retries.
+ */
+void
+picotm_tx_stats_add_commit(struct picotm_tx_stats* self,
+                           unsigned long nretries);
+
+/**
+ * \brief Accounts an aborted transaction.
+ * \param self The statistics.
+ * \param status The error status that caused the abort.
+ */
+void
+picotm_tx_stats_add_abort(struct picotm_tx_stats* self,
+                          enum picotm_error_status status);
+
+/**
+ * \brief Accounts a transaction aborted by picotm_restart().
+ * \param self The statistics.
+ */
+void
+picotm_tx_stats_add_restart(struct picotm_tx_stats* self);
+
+/**
+ * \brief Accounts a transaction that escalated to irrevocable mode.
+ * \param self The statistics.
+ */
+void
+picotm_tx_stats_add_irrevocable(struct picotm_tx_stats* self);
+
+/**
+ * \brief Accounts time spent waiting for a lock.
+ * \param self The statistics.
+ * \param beg The time when waiting began.
+ * \param end The time when waiting ended.
+ */
+void
+picotm_tx_stats_add_wait_time(struct picotm_tx_stats* self,
+                              const struct timespec* beg,
+                              const struct timespec* end);
+
+/**
+ * \brief Accounts time spent in irrevocable mode.
+ * \param self The statistics.
+ * \param beg The time when the transaction became irrevocable.
+ * \param end The time when the transaction released irrevocability.
+ */
+void
+picotm_tx_stats_add_irrevocable_time(struct picotm_tx_stats* self,
+                                     const struct timespec* beg,
+                                     const struct timespec* end);
+
+/**
+ * \brief Aggregates the statistics of all threads.
+ * \param[out] stats Returns the process-wide statistics.
+ */
+void
+picotm_stats_get(struct picotm_stats* stats);
+
+/*
+ * Look-up functions.
+ *
+ * These functions are implemented by the thread-local state handling.
+ */
+
+/**
+ * \brief Returns the statistics of a lock owner's transaction.
+ * \param lo The lock owner.
+ * \returns The transaction statistics.
+ */
+struct picotm_tx_stats*
+picotm_lock_owner_get_tx_stats(struct picotm_lock_owner* lo);
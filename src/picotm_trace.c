@@ -0,0 +1,315 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "picotm_trace.h"
+
+#if defined(PICOTM_HAVE_TRACING) && PICOTM_HAVE_TRACING
+
+#include "picotm/picotm-lib-spinlock.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The number of records in each thread's ring buffer. Must be a
+ * power of 2. */
+#define TRACE_BUFFER_NRECORDS   (4096)
+
+/* A record and its sequence number. The sequence number is the index
+ * of the record plus 1, or 0 while the owning thread writes the record.
+ * Flushing threads use it to detect records that have been overwritten
+ * while they copied them. */
+struct trace_slot {
+    atomic_ulong seq;
+    struct picotm_trace_record record;
+};
+
+struct trace_buffer {
+    struct trace_buffer* next;
+    /* True while a thread owns the buffer. */
+    bool is_used;
+    /* The number of recorded events. Only the owning thread writes
+     * the field. */
+    atomic_ulong head;
+    /* The number of events that have been written to the trace file. */
+    unsigned long nflushed;
+    uint32_t tid;
+    struct trace_slot slot[TRACE_BUFFER_NRECORDS];
+};
+
+/* Trace buffers remain in the list after their threads released
+ * picotm, so that their records are still flushed at exit. New
+ * threads recycle the unused buffers. The spinlock protects the list
+ * and all fields of the buffers, except for the records. */
+static struct picotm_spinlock s_lock = PICOTM_SPINLOCK_INITIALIZER;
+static struct trace_buffer* s_buffers;
+static atomic_uint s_ntids;
+
+static __thread struct trace_buffer* t_buffer;
+
+/** \brief Tracing has not been enabled or disabled yet. */
+#define TRACE_UNSET (-1)
+
+static atomic_int s_enabled = TRACE_UNSET;
+static const char* s_filename;
+
+/* True once the header has been written. Later flushes append to
+ * the trace file. */
+static bool s_has_header;
+
+static void
+flush_at_exit(void)
+{
+    picotm_trace_flush();
+}
+
+static bool
+is_enabled(void)
+{
+    int enabled = atomic_load_explicit(&s_enabled, memory_order_acquire);
+    if (enabled != TRACE_UNSET) {
+        return enabled;
+    }
+
+    picotm_spinlock_lock(&s_lock);
+
+    enabled = atomic_load_explicit(&s_enabled, memory_order_acquire);
+    if (enabled == TRACE_UNSET) {
+        s_filename = getenv("PICOTM_TRACE_FILE");
+        enabled = s_filename && !atexit(flush_at_exit);
+        atomic_store_explicit(&s_enabled, enabled, memory_order_release);
+    }
+
+    picotm_spinlock_unlock(&s_lock);
+
+    return enabled;
+}
+
+static struct trace_buffer*
+get_buffer(void)
+{
+    if (t_buffer) {
+        return t_buffer;
+    }
+
+    uint32_t tid = atomic_fetch_add_explicit(&s_ntids, 1,
+                                             memory_order_relaxed);
+
+    picotm_spinlock_lock(&s_lock);
+
+    struct trace_buffer* buffer = s_buffers;
+    while (buffer && buffer->is_used) {
+        buffer = buffer->next;
+    }
+
+    if (!buffer) {
+        buffer = malloc(sizeof(*buffer));
+        if (!buffer) {
+            goto out;
+        }
+        atomic_init(&buffer->head, 0);
+        buffer->nflushed = 0;
+        for (size_t i = 0; i < TRACE_BUFFER_NRECORDS; ++i) {
+            atomic_init(&buffer->slot[i].seq, 0);
+        }
+        buffer->next = s_buffers;
+        s_buffers = buffer;
+    }
+
+    /* A recycled buffer keeps its records. They are overwritten in
+     * order, as if the previous thread continued recording. */
+    buffer->is_used = true;
+    buffer->tid = tid;
+
+    t_buffer = buffer;
+
+out:
+    picotm_spinlock_unlock(&s_lock);
+
+    return buffer;
+}
+
+void
+picotm_trace_record(enum picotm_trace_event event, uintptr_t arg)
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    struct trace_buffer* buffer = get_buffer();
+    if (!buffer) {
+        return; /* Out of memory; the event gets lost. */
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    unsigned long head = atomic_load_explicit(&buffer->head,
+                                              memory_order_relaxed);
+
+    struct trace_slot* slot =
+        buffer->slot + (head & (TRACE_BUFFER_NRECORDS - 1));
+
+    /* Invalidate the slot before overwriting the record. */
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->record.ns = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    slot->record.arg = arg;
+    slot->record.tid = buffer->tid;
+    slot->record.event = event;
+    slot->record.reserved = 0;
+
+    atomic_store_explicit(&slot->seq, head + 1, memory_order_release);
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+void
+picotm_trace_release()
+{
+    if (!t_buffer) {
+        return;
+    }
+
+    picotm_spinlock_lock(&s_lock);
+    t_buffer->is_used = false;
+    picotm_spinlock_unlock(&s_lock);
+
+    t_buffer = nullptr;
+}
+
+/* Copies the record with the given index. Returns false if the record
+ * has been overwritten. */
+static bool
+copy_record(const struct trace_slot* slot, unsigned long index,
+            struct picotm_trace_record* record)
+{
+    unsigned long seq = atomic_load_explicit(&slot->seq,
+                                             memory_order_acquire);
+    if (seq != index + 1) {
+        return false;
+    }
+
+    *record = slot->record;
+
+    /* Re-check the sequence number after the copy. */
+    atomic_thread_fence(memory_order_acquire);
+
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq;
+}
+
+static bool
+write_buffer(FILE* file, struct trace_buffer* buffer)
+{
+    unsigned long head = atomic_load_explicit(&buffer->head,
+                                              memory_order_acquire);
+    unsigned long tail = buffer->nflushed;
+    if ((head - tail) > TRACE_BUFFER_NRECORDS) {
+        /* Older records have been overwritten. */
+        tail = head - TRACE_BUFFER_NRECORDS;
+    }
+
+    for (; tail < head; ++tail) {
+        const struct trace_slot* slot =
+            buffer->slot + (tail & (TRACE_BUFFER_NRECORDS - 1));
+
+        /* Threads continue to record events while we flush. Records
+         * that have been overwritten meanwhile are skipped. */
+        struct picotm_trace_record record;
+        if (!copy_record(slot, tail, &record)) {
+            continue;
+        }
+        if (fwrite(&record, sizeof(record), 1, file) != 1) {
+            return false;
+        }
+    }
+
+    buffer->nflushed = head;
+
+    return true;
+}
+
+static bool
+write_header(FILE* file)
+{
+    uint32_t header[2] = {
+        PICOTM_TRACE_VERSION,
+        sizeof(struct picotm_trace_record)
+    };
+    if (fwrite(PICOTM_TRACE_MAGIC, strlen(PICOTM_TRACE_MAGIC), 1, file) != 1) {
+        return false;
+    }
+    if (fwrite(header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    return true;
+}
+
+void
+picotm_trace_flush()
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    picotm_spinlock_lock(&s_lock);
+
+    /* The first flush replaces an existing trace file. All later
+     * flushes only append the records that have been recorded since
+     * the previous flush. */
+
+    FILE* file = fopen(s_filename, s_has_header ? "ab" : "wb");
+    if (!file) {
+        goto out;
+    }
+
+    if (!s_has_header) {
+        s_has_header = write_header(file);
+        if (!s_has_header) {
+            goto out_fclose;
+        }
+    }
+
+    for (struct trace_buffer* buffer = s_buffers;
+                              buffer;
+                              buffer = buffer->next) {
+        if (!write_buffer(file, buffer)) {
+            break;
+        }
+    }
+
+out_fclose:
+    fclose(file);
+out:
+    picotm_spinlock_unlock(&s_lock);
+}
+
+#else
+
+void
+picotm_trace_release()
+{ }
+
+void
+picotm_trace_flush()
+{ }
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * \cond impl || lib_impl
+ * \ingroup lib_impl
+ * \file
+ * \endcond
+ */
+
+/**
+ * \brief Trace events.
+ *
+ * The values are part of the trace-file format. Only append new
+ * events at the end.
+ */
+enum picotm_trace_event {
+    /** A transaction began; the argument is the mode. */
+    PICOTM_TRACE_TX_BEGIN,
+    /** A transaction committed; the argument is the number of retries. */
+    PICOTM_TRACE_TX_COMMIT,
+    /** A transaction rolled back; the argument is the number of
+     *  retries. */
+    PICOTM_TRACE_TX_ROLLBACK,
+    /** A lock has been acquired; the argument is the lock. */
+    PICOTM_TRACE_LOCK_ACQUIRE,
+    /** A lock is blocked by other transactions; the argument
+     *  is the lock. */
+    PICOTM_TRACE_LOCK_BLOCKED,
+    /** A lock could not be acquired; the argument is the lock. */
+    PICOTM_TRACE_LOCK_CONFLICT,
+    /** A lock owner started waiting; the argument is its index. */
+    PICOTM_TRACE_WAIT_BEGIN,
+    /** A lock owner stopped waiting; the argument is true if it
+     *  has been woken up, or false on timeouts. */
+    PICOTM_TRACE_WAIT_END,
+    /** A lock owner has been woken up; the argument is its index. */
+    PICOTM_TRACE_WAKE_UP
+};
+
+/**
+ * \brief A record in the trace file.
+ */
+struct picotm_trace_record {
+    /** The monotonic time of the event in nanoseconds. */
+    uint64_t ns;
+    /** The event's argument. */
+    uint64_t arg;
+    /** The thread's trace id. */
+    uint32_t tid;
+    /** The event, see ::picotm_trace_event. */
+    uint16_t event;
+    /** Reserved; always 0. */
+    uint16_t reserved;
+};
+
+/**
+ * \brief The magic string at the beginning of each trace file.
+ */
+#define PICOTM_TRACE_MAGIC  "PICOTMTR"
+
+/**
+ * \brief The version of the trace-file format.
+ */
+#define PICOTM_TRACE_VERSION    (1)
+
+#if defined(PICOTM_HAVE_TRACING) && PICOTM_HAVE_TRACING
+
+/**
+ * \brief Records an event in the thread's trace buffer.
+ * \param event The event.
+ * \param arg The event's argument.
+ *
+ * Tracing is enabled if the environment variable `PICOTM_TRACE_FILE`
+ * is set. Otherwise the function returns immediately.
+ */
+void
+picotm_trace_record(enum picotm_trace_event event, uintptr_t arg);
+
+/**
+ * \brief Records a trace event.
+ *
+ * Tracing is only compiled in if picotm has been configured
+ * with `--enable-tracing`.
+ */
+#define PICOTM_TRACE(_event, _arg)  \
+    picotm_trace_record((_event), (uintptr_t)(_arg))
+
+#else
+
+#define PICOTM_TRACE(_event, _arg)  \
+    ((void)(_arg))
+
+#endif
+
+/**
+ * \brief Returns the calling thread's trace buffer for re-use by other
+ *        threads.
+ *
+ * The buffer's records remain available for flushing. Without tracing,
+ * the function does nothing.
+ */
+void
+picotm_trace_release(void);
+
+/**
+ * \brief Writes the trace buffers of all threads to the trace file.
+ *
+ * The trace file is given by the environment variable
+ * `PICOTM_TRACE_FILE`. The first flush replaces an existing file;
+ * later flushes append the records since the previous flush. Without
+ * tracing, the function does nothing.
+ */
+void
+picotm_trace_flush(void);
@@ -21,19 +21,15 @@
 #include <assert.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include "picotm/picotm-error.h"
 #include "picotm/picotm-lib-array.h"
 #include "picotm_event.h"
 #include "picotm_lock_manager.h"
+#include "picotm_os_timespec.h"
+#include "picotm_trace.h"
 #include "table.h"
 
-/* The maximum number of retries per transaction. If a transacion reaches
- * this limit it switches to irrevocable mode. The actual limit depends on
- * the system's access pattern. The more conflicts, the lower the limit
- * should be. The current value has been choosen arbitrarily and requires
- * further optimization! */
-static const unsigned long TX_NRETRIES_LIMIT = 10;
-
 void
 picotm_tx_init(struct picotm_tx* self, struct picotm_lock_manager* lm,
                struct picotm_error* error)
@@ -46,8 +42,27 @@ picotm_tx_init(struct picotm_tx* self, struct picotm_lock_manager* lm,
     self->env = nullptr;
     self->mode = TX_MODE_REVOCABLE;
     self->nretries = 0;
+    self->is_readonly = false;
     self->nmodules = 0;
 
+    memset(self->eager_module, 0, sizeof(self->eager_module));
+    memset(self->touched_module, 0, sizeof(self->touched_module));
+    memset(self->savepointless_module, 0,
+           sizeof(self->savepointless_module));
+
+    self->depth = 0;
+    self->nsavepoints = 0;
+
+    /* Marks get allocated by the first nested transaction. */
+    for (size_t i = 0; i < picotm_arraylen(self->savepoint); ++i) {
+        self->savepoint[i].mark = nullptr;
+        self->savepoint[i].nmarks = 0;
+        self->savepoint[i].marklen = 0;
+    }
+
+    picotm_site_table_init(&self->sites);
+    self->site = picotm_site_table_lookup(&self->sites, nullptr);
+
     self->lm = lm;
 
     picotm_lock_owner_init(&self->lo, error);
@@ -60,6 +75,8 @@ picotm_tx_init(struct picotm_tx* self, struct picotm_lock_manager* lm,
         goto err_lock_manager_register_owner;
     }
 
+    picotm_tx_stats_init(&self->stats);
+
     return;
 
 err_lock_manager_register_owner:
@@ -73,10 +90,15 @@ picotm_tx_release(struct picotm_tx* self)
 {
     assert(self);
 
+    picotm_tx_stats_uninit(&self->stats);
     picotm_lock_manager_unregister_owner(self->lm, &self->lo);
     picotm_lock_owner_uninit(&self->lo);
     picotm_log_uninit(&self->log);
 
+    for (size_t i = 0; i < picotm_arraylen(self->savepoint); ++i) {
+        tabfree(self->savepoint[i].mark);
+    }
+
     struct picotm_module* module = self->module;
     const struct picotm_module* module_end = self->module + self->nmodules;
 
@@ -94,6 +116,28 @@ picotm_tx_is_irrevocable(const struct picotm_tx* self)
     return self->mode == TX_MODE_IRREVOCABLE;
 }
 
+bool
+picotm_tx_is_readonly(const struct picotm_tx* self)
+{
+    assert(self);
+
+    return self->is_readonly;
+}
+
+bool
+picotm_tx_is_active(const struct picotm_tx* self)
+{
+    assert(self);
+
+    return !!self->depth;
+}
+
+static bool
+reverts_changes(const struct picotm_module_ops* ops)
+{
+    return ops->undo || ops->undo_event || ops->undo_events;
+}
+
 unsigned long
 picotm_tx_register_module(struct picotm_tx* self,
                           const struct picotm_module_ops* ops, void* data,
@@ -110,11 +154,81 @@ picotm_tx_register_module(struct picotm_tx* self,
 
     picotm_module_init(self->module + module, ops, data);
 
+    /* Modules with a begin call-back observe every transaction. */
+    if (ops->begin) {
+        self->eager_module[module / 64] |= UINT64_C(1) << (module % 64);
+    }
+
+    /* Modules that revert changes without a savepoint call-back
+     * prevent partial roll-backs of nested transactions. */
+    if (reverts_changes(ops) && !ops->rollback_to_savepoint) {
+        self->savepointless_module[module / 64] |=
+            UINT64_C(1) << (module % 64);
+    }
+
     self->nmodules = module + 1;
 
+    /* A module that registers during a running transaction, e.g., from
+     * a signal handler, missed the transaction's begin. We begin the
+     * module now, so that it finishes with the other modules. */
+    if (ops->begin && picotm_tx_is_active(self)) {
+        picotm_module_begin(self->module + module, error);
+        if (picotm_error_is_set(error)) {
+            self->eager_module[module / 64] &= ~(UINT64_C(1) << (module % 64));
+            self->savepointless_module[module / 64] &=
+                ~(UINT64_C(1) << (module % 64));
+            self->nmodules = module;
+            return 0;
+        }
+        picotm_tx_touch_module(self, module);
+    }
+
     return module;
 }
 
+/*
+ * Modules only take part in a transaction's commit or roll-back
+ * after they have been touched by the transaction. A thread that
+ * used many modules once doesn't pay for all of them in each later
+ * transaction.
+ */
+
+void
+picotm_tx_touch_module(struct picotm_tx* self, unsigned long module)
+{
+    assert(self);
+    assert(module < self->nmodules);
+
+    self->touched_module[module / 64] |= UINT64_C(1) << (module % 64);
+}
+
+/* Returns the first touched module at or after 'module', or
+ * MAX_NMODULES if there is none. */
+static unsigned long
+next_touched_module(const struct picotm_tx* self, unsigned long module)
+{
+    while (module < MAX_NMODULES) {
+        uint64_t bits = self->touched_module[module / 64] >> (module % 64);
+        if (bits) {
+            return module + __builtin_ctzll(bits);
+        }
+        module = (module / 64 + 1) * 64;
+    }
+    return MAX_NMODULES;
+}
+
+static void
+untouch_modules_from(struct picotm_tx* self, unsigned long module)
+{
+    size_t i = module / 64;
+
+    self->touched_module[i] &= (UINT64_C(1) << (module % 64)) - 1;
+
+    for (++i; i < picotm_arraylen(self->touched_module); ++i) {
+        self->touched_module[i] = 0;
+    }
+}
+
 void
 picotm_tx_append_event(struct picotm_tx* self, unsigned long module,
                        uint16_t head, uintptr_t tail,
@@ -122,104 +236,159 @@ picotm_tx_append_event(struct picotm_tx* self, unsigned long module,
 {
     assert(self);
 
+    /* Events describe modifications, which read-only
+     * transactions don't perform. */
+    if (self->is_readonly) {
+        picotm_error_set_error_code(error, PICOTM_READ_ONLY);
+        return;
+    }
+
+    picotm_tx_touch_module(self, module);
+
     const struct picotm_event event = PICOTM_EVENT_INITIALIZER(module,
                                                                head,
                                                                tail);
     picotm_log_append(&self->log, &event, error);
-}
-
-static size_t
-begin_cb(void* module, struct picotm_error* error)
-{
-    picotm_module_begin(module, error);
     if (picotm_error_is_set(error)) {
-        return 0;
+        return;
     }
-    return 1;
+
+    picotm_lock_owner_add_karma(&self->lo, 1);
 }
 
-static size_t
-begin_modules(struct picotm_module* module, unsigned long nmodules,
-              struct picotm_error* error)
+void
+picotm_tx_append_events(struct picotm_tx* self, unsigned long module,
+                        size_t nevents, const uint16_t head[],
+                        const uintptr_t tail[], struct picotm_error* error)
 {
-    size_t nwalked = tabwalk_1(module, nmodules, sizeof(*module), begin_cb,
-                               error);
-    if (picotm_error_is_set(error)) {
-        return nwalked;
+    assert(self);
+
+    if (self->is_readonly) {
+        picotm_error_set_error_code(error, PICOTM_READ_ONLY);
+        return;
     }
-    return nwalked;
-}
 
-static size_t
-finish_cb(void* module, struct picotm_error* error)
-{
-    picotm_module_finish(module, error);
+    picotm_tx_touch_module(self, module);
+
+    picotm_log_append_n(&self->log, module, nevents, head, tail, error);
     if (picotm_error_is_set(error)) {
-        return 0;
+        return;
     }
-    return 1;
+
+    picotm_lock_owner_add_karma(&self->lo, nevents);
 }
 
 static void
-finish_modules(struct picotm_module* module, unsigned long nmodules,
-               struct picotm_error* error)
+begin_modules(struct picotm_tx* self, struct picotm_error* error)
 {
-    tabwalk_1(module, nmodules, sizeof(*module), finish_cb, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    memcpy(self->touched_module, self->eager_module,
+           sizeof(self->touched_module));
+
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        picotm_module_begin(self->module + i, error);
+        if (picotm_error_is_set(error)) {
+            /* Only the modules that began have to finish. */
+            untouch_modules_from(self, i);
+            return;
+        }
     }
 }
 
-static inline bool
-log_is_empty(struct picotm_tx* self)
+static void
+finish_modules(struct picotm_tx* self, struct picotm_error* error)
 {
-    return picotm_log_begin(&self->log) == picotm_log_end(&self->log);
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        picotm_module_finish(self->module + i, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+    memset(self->touched_module, 0, sizeof(self->touched_module));
 }
 
 void
 picotm_tx_begin(struct picotm_tx* self, enum picotm_tx_mode mode,
-                bool is_retry, __picotm_jmp_buf* env,
-                struct picotm_error* error)
+                bool is_readonly, bool is_retry, __picotm_jmp_buf* env,
+                const void* site, struct picotm_error* error)
 {
     assert(self);
-    assert(log_is_empty(self));
+    assert(picotm_log_is_empty(&self->log));
 
     unsigned long nretries = is_retry ? self->nretries + 1 : 0;
 
-    if (nretries == TX_NRETRIES_LIMIT) {
-        mode = TX_MODE_IRREVOCABLE;
+    if (!is_retry) {
+        /* Sites that always end up in irrevocable mode start
+         * irrevocably. Retrying them only wastes work. */
+        self->site = picotm_site_table_lookup(&self->sites, site);
+        if (picotm_site_begin(self->site) && (mode == TX_MODE_REVOCABLE)) {
+            mode = TX_MODE_IRREVOCABLE;
+        }
+    }
+
+    /* If a transaction reaches its site's retry limit, it switches
+     * to prioritized mode. A prioritized transaction remains revocable
+     * and runs concurrently with other transactions, but wins all
+     * conflicts over locks. */
+    if ((nretries >= picotm_site_get_nretries_limit(self->site)) &&
+        (mode == TX_MODE_REVOCABLE)) {
+        mode = TX_MODE_PRIORITIZED;
     }
 
     switch (mode) {
         case TX_MODE_REVOCABLE:
             /* If we're not the exclusive transaction, we wait
              * for a possible exclusive transaction to finish. */
-            picotm_lock_manager_wait_irrevocable(self->lm, error);
+            picotm_lock_manager_wait_irrevocable(self->lm, &self->lo, error);
             break;
         case TX_MODE_IRREVOCABLE:
             /* If we're supposed to run exclusively, we wait
              * for the other transactions to finish. */
             picotm_lock_manager_make_irrevocable(self->lm, &self->lo, error);
             break;
+        case TX_MODE_PRIORITIZED:
+            /* If we're supposed to win all conflicts, we wait for
+             * other prioritized transactions to finish. */
+            picotm_lock_manager_make_prioritized(self->lm, &self->lo, error);
+            break;
     }
     if (picotm_error_is_set(error)) {
         return;
     }
 
-    /* Reset the timestamp *after* selecting the (ir-)revocability
+    /* Reset the timestamps *after* selecting the (ir-)revocability
      * mode. Otherwise the waiting time, and thus the time of a
      * running irrevocable transaction, would be accounted to this
      * transaction as well. */
-    picotm_lock_owner_reset_timestamp(&self->lo, error);
+    picotm_lock_owner_reset_timestamp(&self->lo, nretries, error);
     if (picotm_error_is_set(error)) {
         goto err_picotm_lock_owner_reset_timestamp;
     }
+    if (mode == TX_MODE_IRREVOCABLE) {
+        /* Only irrevocable transactions need the precise time, for
+         * their statistics. */
+        picotm_os_get_timespec(&self->irrevocable_timestamp, error);
+        if (picotm_error_is_set(error)) {
+            goto err_picotm_lock_owner_reset_timestamp;
+        }
+        picotm_tx_stats_add_irrevocable(&self->stats);
+    }
 
     self->nretries = nretries;
     self->mode = mode;
+    self->is_readonly = is_readonly;
     self->env = env;
+    self->depth = 1;
+    self->nsavepoints = 0;
+
+    picotm_lock_owner_set_readonly(&self->lo, is_readonly);
 
-    size_t nbegin = begin_modules(self->module, self->nmodules, error);
+    PICOTM_TRACE(PICOTM_TRACE_TX_BEGIN, mode);
+
+    begin_modules(self, error);
     if (picotm_error_is_set(error)) {
         goto err_begin_modules;
     }
@@ -227,8 +396,9 @@ picotm_tx_begin(struct picotm_tx* self, enum picotm_tx_mode mode,
     return;
 
 err_begin_modules: {
+        self->depth = 0;
         struct picotm_error err_error = PICOTM_ERROR_INITIALIZER;
-        finish_modules(self->module, nbegin, &err_error);
+        finish_modules(self, &err_error);
         if (picotm_error_is_set(&err_error)) {
             picotm_error_mark_as_non_recoverable(error);
             return;
@@ -238,118 +408,164 @@ err_picotm_lock_owner_reset_timestamp:
     picotm_lock_manager_release_irrevocability(self->lm, &self->lo);
 }
 
-static size_t
-prepare_commit_cb(void* module, void* is_irrevocable,
-                  struct picotm_error* error)
+static void
+release_irrevocability(struct picotm_tx* self)
 {
-    assert(is_irrevocable);
-
-    picotm_module_prepare_commit(module, *((bool*)is_irrevocable), error);
-    if (picotm_error_is_set(error)) {
-        return 0;
+    if (picotm_tx_is_irrevocable(self)) {
+        struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+        struct timespec now;
+        picotm_os_get_timespec(&now, &error);
+        if (!picotm_error_is_set(&error)) {
+            picotm_tx_stats_add_irrevocable_time(
+                &self->stats, &self->irrevocable_timestamp, &now);
+        }
     }
-    return 1;
+
+    picotm_lock_manager_release_irrevocability(self->lm, &self->lo);
 }
 
 static void
-prepare_commit_modules(struct picotm_module* module, unsigned long nmodules,
-                       bool is_irrevocable, struct picotm_error* error)
+prepare_commit_modules(struct picotm_tx* self, bool is_irrevocable,
+                       struct picotm_error* error)
 {
-    tabwalk_2(module, nmodules, sizeof(*module), prepare_commit_cb,
-              &is_irrevocable, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        picotm_module_prepare_commit(self->module + i, is_irrevocable,
+                                     error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
     }
 }
 
-static size_t
-apply_cb(void* module, struct picotm_error* error)
+static void
+apply_modules(struct picotm_tx* self, struct picotm_error* error)
 {
-    picotm_module_apply(module, error);
-    if (picotm_error_is_set(error)) {
-        return 0;
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        picotm_module_apply(self->module + i, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
     }
-    return 1;
 }
 
 static void
-apply_modules(struct picotm_module* module, unsigned long nmodules,
-              struct picotm_error* error)
+undo_modules(struct picotm_tx* self, struct picotm_error* error)
 {
-    tabwalk_1(module, nmodules, sizeof(*module), apply_cb, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        picotm_module_undo(self->module + i, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
     }
 }
 
-static size_t
-undo_cb(void* module, struct picotm_error* error)
+/*
+ * Events are usually logged in long runs of consecutive events
+ * from the same module. We hand over each run to its module in a
+ * single call.
+ */
+
+static const struct picotm_event*
+find_run_end(const struct picotm_event* beg, const struct picotm_event* end)
 {
-    picotm_module_undo(module, error);
-    if (picotm_error_is_set(error)) {
-        return 0;
+    const struct picotm_event* pos = beg + 1;
+
+    while ((pos < end) && (pos->module == beg->module)) {
+        ++pos;
     }
-    return 1;
+    return pos;
 }
 
-static void
-undo_modules(struct picotm_module* module, unsigned long nmodules,
-             struct picotm_error* error)
+static const struct picotm_event*
+find_run_beg(const struct picotm_event* beg, const struct picotm_event* end)
 {
-    tabwalk_1(module, nmodules, sizeof(*module), undo_cb, error);
-    if (picotm_error_is_set(error)) {
-        return;
+    const struct picotm_event* pos = end - 1;
+
+    while ((beg < pos) && ((pos - 1)->module == (end - 1)->module)) {
+        --pos;
     }
+    return pos;
 }
 
 static void
-apply_event(struct picotm_tx* tx, const struct picotm_event* event,
-            struct picotm_error* error)
+apply_event_block_cb(const struct picotm_event* beg,
+                     const struct picotm_event* end, void* data,
+                     struct picotm_error* error)
 {
-    picotm_module_apply_event(tx->module + event->module,
-                              event->head, event->tail,
-                              error);
-}
+    struct picotm_tx* self = data;
 
-static void
-apply_event_cb(struct picotm_event* event, void* data,
-               struct picotm_error* error)
-{
-    apply_event(data, event, error);
+    while (beg < end) {
+        const struct picotm_event* run_end = find_run_end(beg, end);
+        picotm_module_apply_events(self->module + beg->module,
+                                   beg, run_end - beg, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        beg = run_end;
+    }
 }
 
 static void
 apply_events(struct picotm_tx* self, struct picotm_error* error)
 {
-    picotm_events_foreach1(picotm_log_begin(&self->log),
-                           picotm_log_end(&self->log),
-                           self, apply_event_cb, error);
+    picotm_log_foreach_block1(&self->log, self, apply_event_block_cb, error);
     picotm_log_clear(&self->log);
 }
 
 static void
-undo_event(struct picotm_tx* tx, const struct picotm_event* event,
-           struct picotm_error* error)
+undo_event_block_cb(const struct picotm_event* beg,
+                    const struct picotm_event* end, void* data,
+                    struct picotm_error* error)
 {
-    picotm_module_undo_event(tx->module + event->module,
-                             event->head, event->tail,
-                             error);
+    struct picotm_tx* self = data;
+
+    while (beg < end) {
+        const struct picotm_event* run_beg = find_run_beg(beg, end);
+        picotm_module_undo_events(self->module + run_beg->module,
+                                  run_beg, end - run_beg, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        end = run_beg;
+    }
 }
 
 static void
-undo_event_cb(struct picotm_event* event, void* data,
-              struct picotm_error* error)
+undo_events(struct picotm_tx* self, struct picotm_error* error)
 {
-    undo_event(data, event, error);
+    picotm_log_rev_foreach_block1(&self->log, self, undo_event_block_cb,
+                                  error);
+    picotm_log_clear(&self->log);
 }
 
+/* Releases the savepoint of a committing nested transaction. Its
+ * changes become part of the parent transaction. */
 static void
-undo_events(struct picotm_tx* self, struct picotm_error* error)
+release_savepoint(struct picotm_tx* self, struct picotm_error* error)
 {
-    picotm_events_rev_foreach1(picotm_log_begin(&self->log),
-                               picotm_log_end(&self->log),
-                               self, undo_event_cb, error);
-    picotm_log_clear(&self->log);
+    assert(self->nsavepoints);
+
+    const struct picotm_savepoint* savepoint =
+        self->savepoint + self->nsavepoints - 1;
+
+    const struct picotm_savepoint_mark* mark = savepoint->mark;
+    const struct picotm_savepoint_mark* mark_end = mark + savepoint->nmarks;
+
+    for (; mark < mark_end; ++mark) {
+        picotm_module_release_savepoint(self->module + mark->module,
+                                        mark->mark, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+
+    --self->nsavepoints;
 }
 
 void
@@ -357,11 +573,31 @@ picotm_tx_commit(struct picotm_tx* self, struct picotm_error* error)
 {
     assert(self);
 
+    if (self->depth > 1) {
+        /* A nested transaction becomes part of its parent. Only
+         * nested transactions with a savepoint release it. */
+        if (self->depth == self->nsavepoints + 1) {
+            release_savepoint(self, error);
+            if (picotm_error_is_set(error)) {
+                return;
+            }
+        }
+        --self->depth;
+        return;
+    }
+
     bool is_irrevocable = picotm_tx_is_irrevocable(self);
     bool is_non_recoverable = false;
 
-    prepare_commit_modules(self->module, self->nmodules, is_irrevocable,
-                           error);
+    /* A read-only transaction has neither logged events nor
+     * modifications to apply. Finishing the modules releases
+     * its reader locks. */
+    if (self->is_readonly) {
+        assert(picotm_log_is_empty(&self->log));
+        goto finish;
+    }
+
+    prepare_commit_modules(self, is_irrevocable, error);
     if (picotm_error_is_set(error)) {
         goto err_prepare_commit_modules;
     }
@@ -372,7 +608,7 @@ picotm_tx_commit(struct picotm_tx* self, struct picotm_error* error)
 
     is_non_recoverable = true;
 
-    apply_modules(self->module, self->nmodules, error);
+    apply_modules(self, error);
     if (picotm_error_is_set(error)) {
         goto err_apply_modules;
     }
@@ -382,12 +618,21 @@ picotm_tx_commit(struct picotm_tx* self, struct picotm_error* error)
         goto err_apply_events;
     }
 
-    finish_modules(self->module, self->nmodules, error);
+finish:
+    finish_modules(self, error);
     if (picotm_error_is_set(error)) {
         goto err;
     }
 
-    picotm_lock_manager_release_irrevocability(self->lm, &self->lo);
+    release_irrevocability(self);
+
+    self->depth = 0;
+    self->nsavepoints = 0;
+
+    picotm_site_commit(self->site, self->nretries, is_irrevocable);
+    picotm_tx_stats_add_commit(&self->stats, self->nretries);
+
+    PICOTM_TRACE(PICOTM_TRACE_TX_COMMIT, self->nretries);
 
     return;
 
@@ -398,6 +643,10 @@ err:
     if (is_non_recoverable) {
         picotm_error_mark_as_non_recoverable(error);
     }
+    if (error->is_non_recoverable) {
+        /* Nobody rolls back after non-recoverable errors. */
+        picotm_tx_abort(self);
+    }
 }
 
 void
@@ -405,7 +654,9 @@ picotm_tx_rollback(struct picotm_tx* self, struct picotm_error* error)
 {
     assert(self);
 
-    undo_modules(self->module, self->nmodules, error);
+    PICOTM_TRACE(PICOTM_TRACE_TX_ROLLBACK, self->nretries);
+
+    undo_modules(self, error);
     if (picotm_error_is_set(error)) {
         goto err;
     }
@@ -415,16 +666,193 @@ picotm_tx_rollback(struct picotm_tx* self, struct picotm_error* error)
         goto err;
     }
 
-    finish_modules(self->module, self->nmodules, error);
+    finish_modules(self, error);
     if (picotm_error_is_set(error)) {
         goto err;
     }
 
-    picotm_lock_manager_release_irrevocability(self->lm, &self->lo);
+    release_irrevocability(self);
+
+    self->depth = 0;
+    self->nsavepoints = 0;
 
     return;
 
 err:
     picotm_error_mark_as_non_recoverable(error);
-    picotm_lock_manager_release_irrevocability(self->lm, &self->lo);
+    picotm_tx_abort(self);
+}
+
+void
+picotm_tx_abort(struct picotm_tx* self)
+{
+    assert(self);
+
+    if (!picotm_tx_is_active(self)) {
+        return; /* The transaction already ended. */
+    }
+
+    PICOTM_TRACE(PICOTM_TRACE_TX_ROLLBACK, self->nretries);
+
+    /* After a non-recoverable error, the transaction's changes can
+     * neither be applied nor reverted. We release the transaction's
+     * resources, so that the thread can run further transactions.
+     * The caller already handles an error, so further errors are
+     * ignored. */
+
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+        picotm_module_finish(self->module + i, &error);
+    }
+    memset(self->touched_module, 0, sizeof(self->touched_module));
+
+    picotm_log_clear(&self->log);
+
+    release_irrevocability(self);
+
+    self->depth = 0;
+    self->nsavepoints = 0;
+}
+
+/*
+ * Nested transactions keep a savepoint with the end of the event log
+ * and a mark from each module. On conflicts, a nested transaction
+ * rolls back to its savepoint and retries while its parent keeps
+ * all of its locks.
+ */
+
+void
+picotm_tx_begin_nested(struct picotm_tx* self, __picotm_jmp_buf* env,
+                       struct picotm_error* error)
+{
+    assert(self);
+    assert(picotm_tx_is_active(self));
+
+    if (self->nsavepoints == picotm_arraylen(self->savepoint)) {
+        ++self->depth;
+        return;
+    }
+
+    struct picotm_savepoint* savepoint = self->savepoint + self->nsavepoints;
+
+    savepoint->nmarks = 0;
+
+    for (unsigned long i = 0; i < self->nmodules; ++i) {
+        if (!self->module[i].ops->savepoint) {
+            continue;
+        }
+        if (savepoint->nmarks == savepoint->marklen) {
+            void* mark = tabresize(savepoint->mark, savepoint->marklen,
+                                   savepoint->marklen + 1,
+                                   sizeof(*savepoint->mark), error);
+            if (picotm_error_is_set(error)) {
+                return;
+            }
+            savepoint->mark = mark;
+            ++savepoint->marklen;
+        }
+        /* Modules with savepoints finish at the end of the
+         * transaction. */
+        picotm_tx_touch_module(self, i);
+        struct picotm_savepoint_mark* mark =
+            savepoint->mark + savepoint->nmarks;
+        mark->module = i;
+        mark->mark = picotm_module_savepoint(self->module + i, error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+        ++savepoint->nmarks;
+    }
+
+    picotm_log_get_mark(&self->log, &savepoint->log_mark);
+
+    savepoint->env = env;
+    savepoint->nretries = 0;
+    savepoint->nmodules = self->nmodules;
+
+    ++self->nsavepoints;
+    ++self->depth;
+}
+
+bool
+picotm_tx_can_rollback_to_savepoint(const struct picotm_tx* self)
+{
+    assert(self);
+
+    if (!self->nsavepoints || picotm_tx_is_irrevocable(self)) {
+        return false;
+    }
+
+    /* Conflicts that persist are resolved by restarting the
+     * outermost transaction, which releases all of its locks. */
+    const struct picotm_savepoint* savepoint =
+        self->savepoint + self->nsavepoints - 1;
+    if (savepoint->nretries >= picotm_site_get_nretries_limit(self->site)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < picotm_arraylen(self->touched_module); ++i) {
+        if (self->touched_module[i] & self->savepointless_module[i]) {
+            return false;
+        }
+    }
+
+    /* Modules registered after the savepoint have no mark. */
+    for (unsigned long i = next_touched_module(self, savepoint->nmodules);
+                       i < MAX_NMODULES;
+                       i = next_touched_module(self, i + 1)) {
+        if (reverts_changes(self->module[i].ops)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+picotm_tx_rollback_to_savepoint(struct picotm_tx* self,
+                                struct picotm_error* error)
+{
+    assert(self);
+    assert(self->nsavepoints);
+
+    struct picotm_savepoint* savepoint =
+        self->savepoint + self->nsavepoints - 1;
+
+    PICOTM_TRACE(PICOTM_TRACE_TX_ROLLBACK, savepoint->nretries);
+
+    const struct picotm_savepoint_mark* mark = savepoint->mark;
+    const struct picotm_savepoint_mark* mark_end = mark + savepoint->nmarks;
+
+    for (unsigned long i = next_touched_module(self, 0);
+                       i < savepoint->nmodules;
+                       i = next_touched_module(self, i + 1)) {
+        /* Modules without savepoints roll back to a mark of 0. */
+        while ((mark < mark_end) && (mark->module < i)) {
+            ++mark;
+        }
+        uintptr_t module_mark = 0;
+        if ((mark < mark_end) && (mark->module == i)) {
+            module_mark = mark->mark;
+        }
+        picotm_module_rollback_to_savepoint(self->module + i, module_mark,
+                                            error);
+        if (picotm_error_is_set(error)) {
+            return;
+        }
+    }
+
+    picotm_log_rev_foreach_block1_after(&self->log, &savepoint->log_mark,
+                                        self, undo_event_block_cb, error);
+    if (picotm_error_is_set(error)) {
+        return;
+    }
+    picotm_log_truncate(&self->log, &savepoint->log_mark);
+
+    ++savepoint->nretries;
+
+    /* Deeper nested transactions without savepoints are gone. */
+    self->depth = self->nsavepoints + 1;
 }
@@ -21,9 +21,12 @@
 
 #include "picotm/picotm.h" /* for __picotm_jmp_buf */
 #include <stdbool.h>
+#include <stdint.h>
 #include "picotm_module.h"
 #include "picotm_lock_owner.h"
 #include "picotm_log.h"
+#include "picotm_site.h"
+#include "picotm_stats.h"
 
 /**
  * \cond impl || lib_impl
@@ -34,12 +37,54 @@
 
 #define MAX_NMODULES    (256)
 
+/* The number of 64-bit words in a bitmap of all modules. */
+#define MODULE_BITMAP_NWORDS    (MAX_NMODULES / 64)
+
+/* The maximum number of savepoints. Deeper nested transactions become
+ * part of the innermost nested transaction with a savepoint. */
+#define MAX_NSAVEPOINTS (8)
+
 struct picotm_error;
 struct picotm_lock_manager;
 
 enum picotm_tx_mode {
     TX_MODE_REVOCABLE,
-    TX_MODE_IRREVOCABLE
+    TX_MODE_IRREVOCABLE,
+    /* Revocable, but wins all conflicts over locks. */
+    TX_MODE_PRIORITIZED
+};
+
+/**
+ * The mark of a module with savepoints.
+ */
+struct picotm_savepoint_mark {
+    /** The module's index. */
+    unsigned long module;
+
+    /** The module-specific mark. */
+    uintptr_t mark;
+};
+
+/**
+ * The state of a transaction at the beginning of a nested transaction.
+ */
+struct picotm_savepoint {
+    /** The nested transaction's jump buffer. */
+    __picotm_jmp_buf* env;
+
+    /** The end of the event log. */
+    struct picotm_log_mark log_mark;
+
+    /** The number of retries of the nested transaction. */
+    unsigned long nretries;
+
+    /** The number of registered modules at the savepoint. */
+    unsigned long nmodules;
+
+    /** The marks of modules with savepoints, sorted by module index. */
+    struct picotm_savepoint_mark* mark;
+    unsigned long nmarks; /**< \brief Number of marks */
+    unsigned long marklen; /**< \brief Number of allocated marks */
 };
 
 struct picotm_tx {
@@ -48,6 +93,21 @@ struct picotm_tx {
     enum picotm_tx_mode mode;
     unsigned long       nretries;
 
+    /** True if the transaction promised not to modify any resources. */
+    bool is_readonly;
+
+    /** The statistics of the transaction's call site. */
+    struct picotm_site* site;
+
+    /** Per-site statistics of all of the thread's transactions. */
+    struct picotm_site_table sites;
+
+    /** The thread's transaction statistics. */
+    struct picotm_tx_stats stats;
+
+    /** The time when the transaction became irrevocable. */
+    struct timespec irrevocable_timestamp;
+
     /** The global lock manager for all transactions. */
     struct picotm_lock_manager* lm;
 
@@ -56,6 +116,25 @@ struct picotm_tx {
 
     unsigned long nmodules; /**< \brief Number allocated modules */
     struct picotm_module module[MAX_NMODULES]; /** \brief Registered modules */
+
+    /** Modules with a begin call-back. Each transaction touches these
+     * modules when it begins. */
+    uint64_t eager_module[MODULE_BITMAP_NWORDS];
+
+    /** Modules touched by the current transaction. Only these modules
+     * take part in commit and roll-back. */
+    uint64_t touched_module[MODULE_BITMAP_NWORDS];
+
+    /** Modules that revert changes, but cannot roll back to a
+     * savepoint. */
+    uint64_t savepointless_module[MODULE_BITMAP_NWORDS];
+
+    /** The nesting depth of the running transaction, or 0 if no
+     * transaction is running. */
+    unsigned long depth;
+
+    unsigned long nsavepoints; /**< \brief Number of savepoints */
+    struct picotm_savepoint savepoint[MAX_NSAVEPOINTS]; /**< \brief Savepoints */
 };
 
 void
@@ -68,23 +147,51 @@ picotm_tx_release(struct picotm_tx* self);
 bool
 picotm_tx_is_irrevocable(const struct picotm_tx* self);
 
+bool
+picotm_tx_is_readonly(const struct picotm_tx* self);
+
+bool
+picotm_tx_is_active(const struct picotm_tx* self);
+
 unsigned long
 picotm_tx_register_module(struct picotm_tx* self,
                           const struct picotm_module_ops* ops, void* data,
                           struct picotm_error* error);
 
+void
+picotm_tx_touch_module(struct picotm_tx* self, unsigned long module);
+
 void
 picotm_tx_append_event(struct picotm_tx* self, unsigned long module,
                        uint16_t head, uintptr_t tail,
                        struct picotm_error* error);
 
+void
+picotm_tx_append_events(struct picotm_tx* self, unsigned long module,
+                        size_t nevents, const uint16_t head[],
+                        const uintptr_t tail[], struct picotm_error* error);
+
 void
 picotm_tx_begin(struct picotm_tx* self, enum picotm_tx_mode mode,
-                bool is_retry, __picotm_jmp_buf* env,
-                struct picotm_error* error);
+                bool is_readonly, bool is_retry, __picotm_jmp_buf* env,
+                const void* site, struct picotm_error* error);
 
 void
 picotm_tx_commit(struct picotm_tx* self, struct picotm_error* error);
 
 void
 picotm_tx_rollback(struct picotm_tx* self, struct picotm_error* error);
+
+void
+picotm_tx_abort(struct picotm_tx* self);
+
+void
+picotm_tx_begin_nested(struct picotm_tx* self, __picotm_jmp_buf* env,
+                       struct picotm_error* error);
+
+bool
+picotm_tx_can_rollback_to_savepoint(const struct picotm_tx* self);
+
+void
+picotm_tx_rollback_to_savepoint(struct picotm_tx* self,
+                                struct picotm_error* error);
@@ -0,0 +1,57 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/stdlib.h"
+#include <stdlib.h>
+#include "bench.h"
+#include "opts.h"
+#include "ptr.h"
+
+/*
+ * Benchmarks transactional memory allocation. Each transaction
+ * allocates a block of the given size and releases it again.
+ */
+
+static void
+malloc_free_bench(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+
+        void* ptr = malloc_tx(param);
+        free_tx(ptr);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static const struct bench_func allocator_bench[] = {
+    {"malloc_tx_free_tx", 8,       malloc_free_bench, nullptr, nullptr},
+    {"malloc_tx_free_tx", 512,     malloc_free_bench, nullptr, nullptr},
+    {"malloc_tx_free_tx", 4096,    malloc_free_bench, nullptr, nullptr},
+    {"malloc_tx_free_tx", 1 << 20, malloc_free_bench, nullptr, nullptr}
+};
+
+int
+main(int argc, char* argv[])
+{
+    return bench_main(argc, argv, PARSE_OPTS_STRING(), allocator_bench,
+                      arraylen(allocator_bench));
+}
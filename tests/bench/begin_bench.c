@@ -0,0 +1,50 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include <stdlib.h>
+#include "bench.h"
+#include "opts.h"
+#include "ptr.h"
+
+/*
+ * Benchmarks begin and commit of empty transactions on multiple
+ * threads. Total throughput should scale with the number of threads,
+ * as empty transactions don't share any data.
+ */
+
+static void
+empty_tx(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static const struct bench_func begin_bench[] = {
+    {"empty_tx", 0, empty_tx, nullptr, nullptr}
+};
+
+int
+main(int argc, char* argv[])
+{
+    return bench_main(argc, argv, PARSE_OPTS_STRING(), begin_bench,
+                      arraylen(begin_bench));
+}
@@ -0,0 +1,119 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/picotm-tm.h"
+#include "picotm/picotm-tm-ctypes.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "opts.h"
+#include "thread.h"
+
+/*
+ * Benchmarks transactions under high contention. All threads
+ * increment the same counter in Transactional Memory, so nearly every
+ * concurrent transaction conflicts. The benchmark reports throughput
+ * and the number of restarts per committed transaction.
+ */
+
+static unsigned long g_counter;
+
+static atomic_ulong g_nrestarts;
+
+static unsigned long long
+get_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void
+increment_tx(unsigned int tid, void* data)
+{
+    picotm_begin
+
+        unsigned long value = load_ulong_tx(&g_counter);
+        store_ulong_tx(&g_counter, value + 1);
+
+    picotm_commit
+        abort();
+    picotm_end
+
+    atomic_fetch_add_explicit(&g_nrestarts, picotm_number_of_restarts(),
+                              memory_order_relaxed);
+}
+
+static void
+run_bench(unsigned long nthreads, unsigned long long ntxs)
+{
+    g_counter = 0;
+    atomic_store_explicit(&g_nrestarts, 0, memory_order_relaxed);
+
+    unsigned long long beg_ns = get_ns();
+
+    spawn_threads(nthreads, increment_tx, nullptr, INNER_LOOP, CYCLE_BOUND,
+                  ntxs);
+
+    unsigned long long ns = get_ns() - beg_ns;
+    unsigned long long total_txs = nthreads * ntxs;
+
+    if (g_counter != total_txs) {
+        fprintf(stderr, "Counter is %lu, expected %llu\n", g_counter,
+                total_txs);
+        abort();
+    }
+
+    unsigned long nrestarts = atomic_load_explicit(&g_nrestarts,
+                                                   memory_order_relaxed);
+
+    printf("%lu,%llu,%llu,%.0f,%.3f\n", nthreads, total_txs, ns,
+           (double)total_txs * 1000000000.0 / ns,
+           (double)nrestarts / total_txs);
+}
+
+int
+main(int argc, char* argv[])
+{
+    switch (parse_opts(argc, argv, PARSE_OPTS_STRING())) {
+        case PARSE_OPTS_EXIT:
+            return EXIT_SUCCESS;
+        case PARSE_OPTS_ERROR:
+            return EXIT_FAILURE;
+        default:
+            break;
+    }
+
+    /* Each cycle runs 1000 transactions per thread. */
+    unsigned long long ntxs = g_cycles * 1000ull;
+
+    printf("threads,txs,ns,txs_per_second,restarts_per_tx\n");
+
+    unsigned long nthreads = 1;
+
+    for (; nthreads < g_nthreads; nthreads *= 2) {
+        run_bench(nthreads, ntxs);
+    }
+    run_bench(g_nthreads, ntxs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/unistd.h"
+#include <limits.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "opts.h"
+#include "ptr.h"
+#include "safe_stdio.h"
+#include "safe_stdlib.h"
+#include "safe_unistd.h"
+#include "tempfile.h"
+
+/*
+ * Benchmarks pread() and pwrite() on regular files. Each thread
+ * accesses its own temporary file. Regular files buffer writes until
+ * commit (write-back mode), so the benchmarks include the cost of
+ * applying the writes.
+ */
+
+#define MAX_ACCESS_SIZE (1ul << 16)
+
+static int*           g_fildes;
+static unsigned char* g_buf;
+
+static void
+open_files(unsigned long nthreads, unsigned long long param)
+{
+    g_fildes = safe_calloc(nthreads, sizeof(*g_fildes));
+    g_buf = safe_calloc(nthreads, MAX_ACCESS_SIZE);
+
+    for (unsigned long i = 0; i < nthreads; ++i) {
+
+        char filename[PATH_MAX];
+        safe_snprintf(filename, sizeof(filename),
+                      "%s/fildes_bench-%lu-XXXXXX", temp_path(), i);
+
+        g_fildes[i] = safe_mkstemp(filename);
+        safe_unlink(filename);
+
+        safe_pwrite(g_fildes[i], g_buf, MAX_ACCESS_SIZE, 0);
+    }
+}
+
+static void
+close_files(unsigned long nthreads, unsigned long long param)
+{
+    for (unsigned long i = 0; i < nthreads; ++i) {
+        safe_close(g_fildes[i]);
+    }
+
+    free(g_buf);
+    free(g_fildes);
+}
+
+static void
+pread_bench(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+
+        pread_tx(g_fildes[tid], g_buf + tid * MAX_ACCESS_SIZE, param, 0);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+pwrite_bench(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+
+        pwrite_tx(g_fildes[tid], g_buf + tid * MAX_ACCESS_SIZE, param, 0);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static const struct bench_func fildes_bench[] = {
+    {"pread_tx", 8,               pread_bench, open_files, close_files},
+    {"pread_tx", 512,             pread_bench, open_files, close_files},
+    {"pread_tx", 4096,            pread_bench, open_files, close_files},
+    {"pread_tx", MAX_ACCESS_SIZE, pread_bench, open_files, close_files},
+    {"pwrite_tx", 8,               pwrite_bench, open_files, close_files},
+    {"pwrite_tx", 512,             pwrite_bench, open_files, close_files},
+    {"pwrite_tx", 4096,            pwrite_bench, open_files, close_files},
+    {"pwrite_tx", MAX_ACCESS_SIZE, pwrite_bench, open_files, close_files}
+};
+
+int
+main(int argc, char* argv[])
+{
+    return bench_main(argc, argv, PARSE_OPTS_STRING(), fildes_bench,
+                      arraylen(fildes_bench));
+}
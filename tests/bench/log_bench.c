@@ -0,0 +1,192 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/picotm-module.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "opts.h"
+#include "ptr.h"
+
+/*
+ * Benchmarks for picotm's transaction log. Each benchmark appends
+ * a fixed number of events from a no-op module to the log of a
+ * single transaction. The first transaction of a fresh thread has
+ * to allocate the log; all later transactions re-use it. The batched
+ * benchmark appends the same events with picotm_append_events().
+ */
+
+static __thread bool          t_is_registered;
+static __thread unsigned long t_module;
+
+static void
+release_cb(void* data)
+{
+    t_is_registered = false;
+}
+
+static unsigned long
+get_module(void)
+{
+    static const struct picotm_module_ops s_ops = {
+        .release = release_cb
+    };
+
+    if (t_is_registered) {
+        return t_module;
+    }
+
+    struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+
+    t_module = picotm_register_module(&s_ops, nullptr, &error);
+    if (picotm_error_is_set(&error)) {
+        fprintf(stderr, "picotm_register_module() failed\n");
+        abort();
+    }
+    t_is_registered = true;
+
+    return t_module;
+}
+
+static unsigned long long
+get_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned long long
+run_tx(unsigned long nevents)
+{
+    unsigned long long beg_ns = get_ns();
+
+    picotm_begin
+
+        unsigned long module = get_module();
+
+        for (unsigned long i = 0; i < nevents; ++i) {
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_append_event(module, 0, i, &error);
+            if (picotm_error_is_set(&error)) {
+                picotm_recover_from_error(&error);
+            }
+        }
+
+    picotm_commit
+        abort();
+    picotm_end
+
+    return get_ns() - beg_ns;
+}
+
+static unsigned long long
+run_tx_batched(unsigned long nevents)
+{
+    unsigned long long beg_ns = get_ns();
+
+    picotm_begin
+
+        unsigned long module = get_module();
+
+        uint16_t head[64] = { 0, };
+        uintptr_t tail[arraylen(head)];
+
+        for (unsigned long i = 0; i < nevents; i += arraylen(tail)) {
+
+            size_t n = nevents - i;
+            if (n > arraylen(tail)) {
+                n = arraylen(tail);
+            }
+            for (size_t j = 0; j < n; ++j) {
+                tail[j] = i + j;
+            }
+
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_append_events(module, n, head, tail, &error);
+            if (picotm_error_is_set(&error)) {
+                picotm_recover_from_error(&error);
+            }
+        }
+
+    picotm_commit
+        abort();
+    picotm_end
+
+    return get_ns() - beg_ns;
+}
+
+static void
+run_bench(unsigned long nevents, unsigned long cycles)
+{
+    /* Start with a fresh thread state and an empty log. */
+    picotm_release();
+
+    unsigned long long cold_ns = run_tx(nevents);
+
+    unsigned long long warm_ns = 0;
+
+    for (unsigned long i = 0; i < cycles; ++i) {
+        warm_ns += run_tx(nevents);
+    }
+
+    unsigned long long batched_ns = 0;
+
+    for (unsigned long i = 0; i < cycles; ++i) {
+        batched_ns += run_tx_batched(nevents);
+    }
+
+    printf("%lu,%lu,%.2f,%.2f,%.2f\n", nevents, cycles,
+           (double)cold_ns / nevents,
+           (double)warm_ns / ((double)nevents * cycles),
+           (double)batched_ns / ((double)nevents * cycles));
+}
+
+int
+main(int argc, char* argv[])
+{
+    switch (parse_opts(argc, argv, PARSE_OPTS_STRING())) {
+        case PARSE_OPTS_EXIT:
+            return EXIT_SUCCESS;
+        case PARSE_OPTS_ERROR:
+            return EXIT_FAILURE;
+        default:
+            break;
+    }
+
+    static const unsigned long nevents[] = {
+        10,
+        1000,
+        100000
+    };
+
+    printf("events,cycles,ns_per_append_cold,ns_per_append_warm,"
+           "ns_per_append_batched\n");
+
+    for (size_t i = 0; i < arraylen(nevents); ++i) {
+        run_bench(nevents[i], g_cycles);
+    }
+
+    picotm_release();
+
+    return EXIT_SUCCESS;
+}
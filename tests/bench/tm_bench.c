@@ -0,0 +1,149 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/picotm-tm.h"
+#include "picotm/picotm-tm-ctypes.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "opts.h"
+#include "ptr.h"
+#include "safe_stdlib.h"
+
+/*
+ * Benchmarks loads and stores of Transactional Memory. Each
+ * transaction accesses a contiguous range of the given size. Every
+ * thread works on its own range, so transactions don't conflict.
+ *
+ * The neighbor benchmarks increment a counter per thread. The counters
+ * are placed at the given distance in bytes. If neighboring counters
+ * share a TM block, concurrent transactions conflict although they
+ * access different data. Comparing abort rates for different distances
+ * and block sizes shows the cost of false conflicts.
+ */
+
+#define MAX_ACCESS_SIZE (1ul << 20)
+
+static unsigned char* g_shared;
+static unsigned char* g_local;
+
+static void
+alloc_buffers(unsigned long nthreads, unsigned long long param)
+{
+    g_shared = safe_calloc(nthreads, MAX_ACCESS_SIZE);
+    g_local = safe_calloc(nthreads, MAX_ACCESS_SIZE);
+}
+
+static void
+free_buffers(unsigned long nthreads, unsigned long long param)
+{
+    free(g_local);
+    free(g_shared);
+}
+
+#define MAX_NEIGHBOR_DISTANCE   (64ul)
+
+static void* g_neighbor_buf;
+static unsigned char* g_neighbors;
+
+static void
+alloc_neighbors(unsigned long nthreads, unsigned long long param)
+{
+    /* Align the counters to the largest supported block size. */
+    g_neighbor_buf = safe_calloc(nthreads + 1, MAX_NEIGHBOR_DISTANCE);
+    uintptr_t addr = (uintptr_t)g_neighbor_buf;
+    addr = (addr + MAX_NEIGHBOR_DISTANCE - 1) & ~(MAX_NEIGHBOR_DISTANCE - 1);
+    g_neighbors = (unsigned char*)addr;
+}
+
+static void
+free_neighbors(unsigned long nthreads, unsigned long long param)
+{
+    free(g_neighbor_buf);
+}
+
+static void
+neighbor_bench(unsigned int tid, unsigned long long param)
+{
+    unsigned long* counter = (unsigned long*)(g_neighbors + tid * param);
+
+    picotm_begin
+
+        unsigned long value = load_ulong_tx(counter);
+        store_ulong_tx(counter, value + 1);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+load_bench(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+
+        load_tx(g_shared + tid * MAX_ACCESS_SIZE,
+                g_local + tid * MAX_ACCESS_SIZE, param);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+store_bench(unsigned int tid, unsigned long long param)
+{
+    picotm_begin
+
+        store_tx(g_shared + tid * MAX_ACCESS_SIZE,
+                 g_local + tid * MAX_ACCESS_SIZE, param);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static const struct bench_func tm_bench[] = {
+    {"load_tx",  8,               load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  64,              load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  512,             load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  4096,            load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  32768,           load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  262144,          load_bench,  alloc_buffers, free_buffers},
+    {"load_tx",  MAX_ACCESS_SIZE, load_bench,  alloc_buffers, free_buffers},
+    {"store_tx", 8,               store_bench, alloc_buffers, free_buffers},
+    {"store_tx", 64,              store_bench, alloc_buffers, free_buffers},
+    {"store_tx", 512,             store_bench, alloc_buffers, free_buffers},
+    {"store_tx", 4096,            store_bench, alloc_buffers, free_buffers},
+    {"store_tx", 32768,           store_bench, alloc_buffers, free_buffers},
+    {"store_tx", 262144,          store_bench, alloc_buffers, free_buffers},
+    {"store_tx", MAX_ACCESS_SIZE, store_bench, alloc_buffers, free_buffers},
+    {"neighbor_tx", 8,  neighbor_bench, alloc_neighbors, free_neighbors},
+    {"neighbor_tx", 16, neighbor_bench, alloc_neighbors, free_neighbors},
+    {"neighbor_tx", 32, neighbor_bench, alloc_neighbors, free_neighbors},
+    {"neighbor_tx", 64, neighbor_bench, alloc_neighbors, free_neighbors}
+};
+
+int
+main(int argc, char* argv[])
+{
+    return bench_main(argc, argv, PARSE_OPTS_STRING(), tm_bench,
+                      arraylen(tm_bench));
+}
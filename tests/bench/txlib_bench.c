@@ -0,0 +1,435 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "picotm/picotm.h"
+#include "picotm/picotm-lib-ptr.h"
+#include "picotm/picotm-txlist.h"
+#include "picotm/picotm-txmultiset.h"
+#include "picotm/picotm-txqueue.h"
+#include "picotm/picotm-txstack.h"
+#include <stdlib.h>
+#include "bench.h"
+#include "opts.h"
+#include "ptr.h"
+#include "safe_stdlib.h"
+
+/*
+ * Benchmarks the operations of the transactional data structures. Each
+ * thread works on its own list, queue, stack and multiset, which
+ * initially contain NITEMS items. Modifying benchmarks undo their
+ * changes within the same transaction, so the size of the data
+ * structures remains constant.
+ */
+
+#define NITEMS  (16)
+
+struct item {
+    struct txlist_entry     list_entry;
+    struct txmultiset_entry multiset_entry;
+    struct txqueue_entry    queue_entry;
+    struct txstack_entry    stack_entry;
+
+    unsigned long value;
+};
+
+static const void*
+item_key_cb(struct txmultiset_entry* entry)
+{
+    return &picotm_containerof(entry, struct item, multiset_entry)->value;
+}
+
+static int
+item_compare_cb(const void* lhs, const void* rhs)
+{
+    const unsigned long* lhs_value = lhs;
+    const unsigned long* rhs_value = rhs;
+
+    return (*rhs_value < *lhs_value) - (*lhs_value < *rhs_value);
+}
+
+struct thread_data {
+    struct txlist_state     list_state;
+    struct txmultiset_state multiset_state;
+    struct txqueue_state    queue_state;
+    struct txstack_state    stack_state;
+
+    /* The data structures contain items[0] to items[NITEMS - 1]. The
+     * final item is inserted and removed by the benchmarks. */
+    struct item items[NITEMS + 1];
+};
+
+static struct thread_data* g_thread_data;
+
+static void
+fill_thread_data(struct thread_data* data)
+{
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        struct txmultiset* multiset =
+            txmultiset_of_state_tx(&data->multiset_state);
+        struct txqueue* queue = txqueue_of_state_tx(&data->queue_state);
+        struct txstack* stack = txstack_of_state_tx(&data->stack_state);
+
+        for (struct item* item = data->items;
+                          item < data->items + NITEMS;
+                        ++item) {
+            txlist_push_back_tx(list, &item->list_entry);
+            txmultiset_insert_tx(multiset, &item->multiset_entry);
+            txqueue_push_tx(queue, &item->queue_entry);
+            txstack_push_tx(stack, &item->stack_entry);
+        }
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+init_thread_data(unsigned long nthreads, unsigned long long param)
+{
+    g_thread_data = safe_calloc(nthreads, sizeof(*g_thread_data));
+
+    for (struct thread_data* data = g_thread_data;
+                             data < g_thread_data + nthreads;
+                           ++data) {
+
+        txlist_state_init(&data->list_state);
+        txmultiset_state_init(&data->multiset_state, item_key_cb,
+                              item_compare_cb);
+        txqueue_state_init(&data->queue_state);
+        txstack_state_init(&data->stack_state);
+
+        for (struct item* item = data->items;
+                          item < data->items + arraylen(data->items);
+                        ++item) {
+            txlist_entry_init(&item->list_entry);
+            txmultiset_entry_init(&item->multiset_entry);
+            txqueue_entry_init(&item->queue_entry);
+            txstack_entry_init(&item->stack_entry);
+            item->value = item - data->items;
+        }
+
+        fill_thread_data(data);
+    }
+}
+
+static void
+uninit_list_entry_cb(struct txlist_entry* entry, void* data)
+{
+    txlist_entry_uninit(entry);
+}
+
+static void
+uninit_multiset_entry_cb(struct txmultiset_entry* entry, void* data)
+{
+    txmultiset_entry_uninit(entry);
+}
+
+static void
+uninit_queue_entry_cb(struct txqueue_entry* entry, void* data)
+{
+    txqueue_entry_uninit(entry);
+}
+
+static void
+uninit_stack_entry_cb(struct txstack_entry* entry, void* data)
+{
+    txstack_entry_uninit(entry);
+}
+
+static void
+uninit_thread_data(unsigned long nthreads, unsigned long long param)
+{
+    for (struct thread_data* data = g_thread_data;
+                             data < g_thread_data + nthreads;
+                           ++data) {
+
+        txlist_state_clear_and_uninit_entries(&data->list_state,
+                                              uninit_list_entry_cb,
+                                              nullptr);
+        txlist_state_uninit(&data->list_state);
+
+        txmultiset_state_clear_and_uninit_entries(&data->multiset_state,
+                                                  uninit_multiset_entry_cb,
+                                                  nullptr);
+        txmultiset_state_uninit(&data->multiset_state);
+
+        txqueue_state_clear_and_uninit_entries(&data->queue_state,
+                                               uninit_queue_entry_cb,
+                                               nullptr);
+        txqueue_state_uninit(&data->queue_state);
+
+        txstack_state_clear_and_uninit_entries(&data->stack_state,
+                                               uninit_stack_entry_cb,
+                                               nullptr);
+        txstack_state_uninit(&data->stack_state);
+
+        /* The final item is not in any data structure. */
+        struct item* item = data->items + NITEMS;
+        txlist_entry_uninit(&item->list_entry);
+        txmultiset_entry_uninit(&item->multiset_entry);
+        txqueue_entry_uninit(&item->queue_entry);
+        txstack_entry_uninit(&item->stack_entry);
+    }
+
+    free(g_thread_data);
+}
+
+/*
+ * Lists
+ */
+
+static void
+txlist_front_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        txlist_front_tx(list);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txlist_size_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        txlist_size_tx(list);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txlist_push_pop_back_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        txlist_push_back_tx(list, &data->items[NITEMS].list_entry);
+        txlist_pop_back_tx(list);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txlist_push_pop_front_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        txlist_push_front_tx(list, &data->items[NITEMS].list_entry);
+        txlist_pop_front_tx(list);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txlist_insert_erase_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txlist* list = txlist_of_state_tx(&data->list_state);
+        txlist_insert_tx(list, &data->items[NITEMS].list_entry,
+                         &data->items[NITEMS / 2].list_entry);
+        txlist_erase_tx(list, &data->items[NITEMS].list_entry);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+/*
+ * Multisets
+ */
+
+static void
+txmultiset_find_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txmultiset* multiset =
+            txmultiset_of_state_tx(&data->multiset_state);
+        txmultiset_find_tx(multiset, &data->items[NITEMS / 2].value);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txmultiset_count_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txmultiset* multiset =
+            txmultiset_of_state_tx(&data->multiset_state);
+        txmultiset_count_tx(multiset, &data->items[NITEMS / 2].value);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txmultiset_insert_erase_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txmultiset* multiset =
+            txmultiset_of_state_tx(&data->multiset_state);
+        txmultiset_insert_tx(multiset, &data->items[NITEMS].multiset_entry);
+        txmultiset_erase_tx(multiset, &data->items[NITEMS].multiset_entry);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+/*
+ * Queues
+ */
+
+static void
+txqueue_front_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txqueue* queue = txqueue_of_state_tx(&data->queue_state);
+        txqueue_front_tx(queue);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txqueue_pop_push_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        /* Moves the front item to the back of the queue. */
+        struct txqueue* queue = txqueue_of_state_tx(&data->queue_state);
+        struct txqueue_entry* entry = txqueue_front_tx(queue);
+        txqueue_pop_tx(queue);
+        txqueue_push_tx(queue, entry);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+/*
+ * Stacks
+ */
+
+static void
+txstack_top_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txstack* stack = txstack_of_state_tx(&data->stack_state);
+        txstack_top_tx(stack);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static void
+txstack_push_pop_bench(unsigned int tid, unsigned long long param)
+{
+    struct thread_data* data = g_thread_data + tid;
+
+    picotm_begin
+
+        struct txstack* stack = txstack_of_state_tx(&data->stack_state);
+        txstack_push_tx(stack, &data->items[NITEMS].stack_entry);
+        txstack_pop_tx(stack);
+
+    picotm_commit
+        abort();
+    picotm_end
+}
+
+static const struct bench_func txlib_bench[] = {
+    {"txlist_front",          0, txlist_front_bench,
+     init_thread_data, uninit_thread_data},
+    {"txlist_size",           0, txlist_size_bench,
+     init_thread_data, uninit_thread_data},
+    {"txlist_push_pop_back",  0, txlist_push_pop_back_bench,
+     init_thread_data, uninit_thread_data},
+    {"txlist_push_pop_front", 0, txlist_push_pop_front_bench,
+     init_thread_data, uninit_thread_data},
+    {"txlist_insert_erase",   0, txlist_insert_erase_bench,
+     init_thread_data, uninit_thread_data},
+    {"txmultiset_find",         0, txmultiset_find_bench,
+     init_thread_data, uninit_thread_data},
+    {"txmultiset_count",        0, txmultiset_count_bench,
+     init_thread_data, uninit_thread_data},
+    {"txmultiset_insert_erase", 0, txmultiset_insert_erase_bench,
+     init_thread_data, uninit_thread_data},
+    {"txqueue_front",    0, txqueue_front_bench,
+     init_thread_data, uninit_thread_data},
+    {"txqueue_pop_push", 0, txqueue_pop_push_bench,
+     init_thread_data, uninit_thread_data},
+    {"txstack_top",      0, txstack_top_bench,
+     init_thread_data, uninit_thread_data},
+    {"txstack_push_pop", 0, txstack_push_pop_bench,
+     init_thread_data, uninit_thread_data}
+};
+
+int
+main(int argc, char* argv[])
+{
+    return bench_main(argc, argv, PARSE_OPTS_STRING(), txlib_bench,
+                      arraylen(txlib_bench));
+}
@@ -0,0 +1,258 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "bench.h"
+#include "picotm/picotm.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "opts.h"
+#include "safeblk.h"
+#include "thread.h"
+
+/*
+ * Latency histograms
+ *
+ * Each thread records the latency of its transactions in a
+ * log-linear histogram. Each power of 2 is split into 16 linear
+ * buckets, so reported percentiles are within 1/16th of the exact
+ * value.
+ */
+
+#define HISTOGRAM_SUB_BITS      (4)
+#define HISTOGRAM_NSUBBUCKETS   (1ul << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_NBUCKETS      (64 * HISTOGRAM_NSUBBUCKETS)
+
+struct histogram {
+    unsigned long long count[HISTOGRAM_NBUCKETS];
+};
+
+static size_t
+histogram_index(unsigned long long ns)
+{
+    if (ns < HISTOGRAM_NSUBBUCKETS) {
+        return ns;
+    }
+
+    unsigned int exp = 63 - __builtin_clzll(ns);
+    unsigned int shift = exp - HISTOGRAM_SUB_BITS;
+
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) +
+           ((ns >> shift) & (HISTOGRAM_NSUBBUCKETS - 1));
+}
+
+static unsigned long long
+histogram_value(size_t index)
+{
+    if (index < HISTOGRAM_NSUBBUCKETS) {
+        return index;
+    }
+
+    unsigned int shift = (index >> HISTOGRAM_SUB_BITS) - 1;
+    unsigned long long sub = index & (HISTOGRAM_NSUBBUCKETS - 1);
+
+    return (HISTOGRAM_NSUBBUCKETS + sub) << shift;
+}
+
+static unsigned long long
+histogram_percentile(const struct histogram* self, unsigned long long total,
+                     double percentile)
+{
+    unsigned long long rank = (unsigned long long)(total * percentile);
+    unsigned long long sum = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_NBUCKETS; ++i) {
+        sum += self->count[i];
+        if (sum > rank) {
+            return histogram_value(i);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Benchmark runs
+ */
+
+static const struct bench_func* g_bench;
+static struct histogram* g_histogram;
+
+static unsigned long long
+get_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned long long
+get_naborts(const struct picotm_stats* stats)
+{
+    return stats->naborts_conflicting +
+           stats->naborts_revocable +
+           stats->naborts_error_code +
+           stats->naborts_errno +
+           stats->naborts_kern_return_t +
+           stats->naborts_siginfo_t +
+           stats->naborts_restart;
+}
+
+static void
+timed_call(unsigned int tid, void* data)
+{
+    unsigned long long beg_ns = get_ns();
+
+    g_bench->call(tid, g_bench->param);
+
+    ++g_histogram[tid].count[histogram_index(get_ns() - beg_ns)];
+}
+
+static bool
+run_bench(const struct bench_func* bench, unsigned long nthreads,
+          enum loop_mode loop, enum boundary_type btype,
+          unsigned long long limit)
+{
+    if (bench->pre) {
+        bench->pre(nthreads, bench->param);
+    }
+
+    memset(g_histogram, 0, nthreads * sizeof(*g_histogram));
+    g_bench = bench;
+
+    struct picotm_stats beg_stats;
+    picotm_get_stats(&beg_stats);
+
+    unsigned long long beg_ns = get_ns();
+
+    bool aborted;
+
+    begin_safe_block(aborted)
+        spawn_threads(nthreads, timed_call, nullptr, loop, btype, limit);
+    end_safe_block
+
+    unsigned long long ns = get_ns() - beg_ns;
+
+    if (aborted) {
+        fprintf(stderr, "Benchmark %s aborted\n", bench->name);
+        return false;
+    }
+
+    struct picotm_stats end_stats;
+    picotm_get_stats(&end_stats);
+
+    if (bench->post) {
+        bench->post(nthreads, bench->param);
+    }
+
+    /* Merge the per-thread histograms into the first one. */
+
+    unsigned long long ntxs = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_NBUCKETS; ++i) {
+        for (unsigned long j = 1; j < nthreads; ++j) {
+            g_histogram->count[i] += g_histogram[j].count[i];
+        }
+        ntxs += g_histogram->count[i];
+    }
+
+    unsigned long long ncommits = end_stats.ncommits - beg_stats.ncommits;
+    unsigned long long naborts = get_naborts(&end_stats) -
+                                 get_naborts(&beg_stats);
+
+    double abort_rate = 0;
+    if (ncommits + naborts) {
+        abort_rate = (double)naborts / (double)(ncommits + naborts);
+    }
+
+    printf("%s,%llu,%lu,%llu,%llu,%.0f,%.4f,%llu,%llu\n",
+           bench->name, bench->param, nthreads, ntxs, ns,
+           (double)ntxs * 1000000000.0 / ns, abort_rate,
+           histogram_percentile(g_histogram, ntxs, 0.50),
+           histogram_percentile(g_histogram, ntxs, 0.99));
+    fflush(stdout);
+
+    return true;
+}
+
+int
+bench_main(int argc, char** argv, const char* optstring,
+           const struct bench_func* bench, size_t nbenches)
+{
+    switch (parse_opts(argc, argv, optstring)) {
+        case PARSE_OPTS_EXIT:
+            return EXIT_SUCCESS;
+        case PARSE_OPTS_ERROR:
+            return EXIT_FAILURE;
+        default:
+            break;
+    }
+
+    if (nbenches <= g_off) {
+        fprintf(stderr, "Benchmark index out of range\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t off = g_off;
+    size_t num;
+
+    if (!g_num) {
+        num = nbenches - off;
+    } else {
+        num = g_num;
+    }
+
+    if (nbenches < (off + num)) {
+        fprintf(stderr, "Benchmark index out of range\n");
+        return EXIT_FAILURE;
+    }
+
+    g_histogram = malloc(g_nthreads * sizeof(*g_histogram));
+    if (!g_histogram) {
+        perror("malloc()");
+        return EXIT_FAILURE;
+    }
+
+    printf("bench,param,threads,txs,ns,txs_per_second,abort_rate,"
+           "p50_ns,p99_ns\n");
+
+    const struct bench_func* beg = bench + off;
+    const struct bench_func* end = bench + off + num;
+
+    bool succeeded = true;
+
+    for (; succeeded && (beg < end); ++beg) {
+
+        unsigned long nthreads = 1;
+
+        for (; succeeded && (nthreads < g_nthreads); nthreads *= 2) {
+            succeeded = run_bench(beg, nthreads, g_loop, g_btype, g_cycles);
+        }
+        if (succeeded) {
+            succeeded = run_bench(beg, g_nthreads, g_loop, g_btype,
+                                  g_cycles);
+        }
+    }
+
+    free(g_histogram);
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
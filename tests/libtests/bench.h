@@ -0,0 +1,53 @@
+/*
+ * picotm - A system-level transaction manager
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Benchmarks run a transaction on 1, 2, 4, ... up to the number of
+ * threads given with '-t'. Each thread runs the transaction for the
+ * number of cycles given with '-c', or for the given number of
+ * milliseconds if '-b time' has been specified. For each run, the
+ * benchmark prints a line of CSV output with the throughput, the
+ * abort rate, and the 50th and 99th percentile of the latency of
+ * a transaction.
+ */
+
+typedef void (* const bench_pre_func)(unsigned long, unsigned long long);
+typedef void (* const bench_post_func)(unsigned long, unsigned long long);
+typedef void (* const bench_call_func)(unsigned int, unsigned long long);
+
+struct bench_func {
+
+    const char* name;
+
+    /* A benchmark-specific parameter, such as the size of an access,
+     * or 0 if unused. */
+    unsigned long long param;
+
+    bench_call_func call;
+    bench_pre_func  pre;
+    bench_post_func post;
+};
+
+int
+bench_main(int argc, char** argv, const char* optstring,
+           const struct bench_func* bench, size_t nbenches);
@@ -18,8 +18,11 @@
  */
 
 #include "picotm/picotm.h"
+#include "picotm/picotm-lib-rwlock.h"
 #include "picotm/picotm-module.h"
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "ptr.h"
 #include "safeblk.h"
 #include "taputils.h"
@@ -125,11 +128,588 @@ core_test_4(unsigned int tid)
     }
 }
 
+/* Test 5
+ */
+
+static const char core_test_5_desc[] =
+    "Test transactions with all contention-management policies.";
+
+static void
+core_test_5_tx(enum picotm_contention_policy policy)
+{
+    picotm_set_contention_policy(policy);
+
+    picotm_begin
+    picotm_commit
+    picotm_end
+}
+
+static void
+core_test_5_check_policy(void)
+{
+    /* Concurrent threads might have changed the policy meanwhile,
+     * but it's always one of the valid policies. */
+    if (picotm_get_contention_policy() > PICOTM_CONTENTION_POLICY_AGGRESSIVE) {
+        tap_error("Invalid contention-management policy.\n");
+        abort_safe_block();
+    }
+}
+
+static void
+core_test_5(unsigned int tid)
+{
+    static const enum picotm_contention_policy policy[] = {
+        PICOTM_CONTENTION_POLICY_GREEDY,
+        PICOTM_CONTENTION_POLICY_KARMA,
+        PICOTM_CONTENTION_POLICY_POLKA,
+        PICOTM_CONTENTION_POLICY_PASSIVE,
+        PICOTM_CONTENTION_POLICY_AGGRESSIVE
+    };
+
+    for (size_t i = 0; i < arraylen(policy); ++i) {
+        core_test_5_tx(policy[i]);
+    }
+
+    core_test_5_check_policy();
+
+    /* Invalid policies are ignored. */
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_AGGRESSIVE + 1);
+    core_test_5_check_policy();
+    picotm_set_contention_policy((enum picotm_contention_policy)-1);
+    core_test_5_check_policy();
+
+    /* Restore the default policy. */
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_GREEDY);
+}
+
+/* Test 6
+ */
+
+static const char core_test_6_desc[] =
+    "Test call sites that always escalate to irrevocable mode.";
+
+static unsigned long
+core_test_6_tx(void)
+{
+    unsigned long nrestarts = 0;
+
+    picotm_begin
+
+        picotm_irrevocable();
+
+        nrestarts = picotm_number_of_restarts();
+
+    picotm_commit
+    picotm_end
+
+    return nrestarts;
+}
+
+static void
+core_test_6(unsigned int tid)
+{
+    static const unsigned long NTXS = 100;
+
+    struct picotm_stats beg;
+    picotm_get_stats(&beg);
+
+    unsigned long nrestarts = 0;
+
+    for (unsigned long i = 0; i < NTXS; ++i) {
+        nrestarts += core_test_6_tx();
+    }
+
+    struct picotm_stats end;
+    picotm_get_stats(&end);
+
+    /* Each transaction escalates to irrevocable mode, either after a
+     * restart or right from the start. */
+    if (end.nirrevocable < (beg.nirrevocable + NTXS)) {
+        tap_error("Escalation to irrevocable mode has not been counted.\n");
+        abort_safe_block();
+    }
+
+    /* After a few transactions, the call site starts in irrevocable
+     * mode. Only occasional probes start revocably. */
+    if (nrestarts > (NTXS / 10)) {
+        tap_error("Call site did not start in irrevocable mode.\n");
+        abort_safe_block();
+    }
+}
+
+/* Test 7
+ */
+
+static const char core_test_7_desc[] = "Test transaction statistics.";
+
+static void
+core_test_7_tx(void)
+{
+    picotm_begin
+
+        if (!picotm_number_of_restarts()) {
+            picotm_restart();
+        }
+
+    picotm_commit
+    picotm_end
+}
+
+static void
+core_test_7(unsigned int tid)
+{
+    struct picotm_stats beg;
+    picotm_get_stats(&beg);
+
+    core_test_7_tx();
+
+    struct picotm_stats end;
+    picotm_get_stats(&end);
+
+    /* Concurrent threads update the statistics as well, so we
+     * only test for lower bounds. */
+
+    if (end.ncommits < (beg.ncommits + 1)) {
+        tap_error("Commit has not been counted.\n");
+        abort_safe_block();
+    }
+    if (end.nretries < (beg.nretries + 1)) {
+        tap_error("Retry has not been counted.\n");
+        abort_safe_block();
+    }
+    if (end.naborts_restart < (beg.naborts_restart + 1)) {
+        tap_error("Restart has not been counted.\n");
+        abort_safe_block();
+    }
+    if (!end.max_nretries) {
+        tap_error("Maximum number of retries has not been counted.\n");
+        abort_safe_block();
+    }
+}
+
+/* Test 8
+ */
+
+static const char core_test_8_desc[] = "Test conflict profiling.";
+
+static struct picotm_rwlock core_test_8_lock;
+
+static void
+core_test_8_describe_lock(const struct picotm_rwlock* lock, const void* data,
+                          char* buf, size_t siz)
+{
+    snprintf(buf, siz, "core test 8");
+}
+
+static void
+core_test_8_pre(unsigned long nthreads, enum loop_mode loop,
+                enum boundary_type btype, unsigned long long bound)
+{
+    picotm_set_conflict_profiling(true);
+
+    picotm_rwlock_init(&core_test_8_lock);
+    picotm_register_lock_range(&core_test_8_lock, &core_test_8_lock + 1,
+                               core_test_8_describe_lock, nullptr);
+}
+
+static void
+core_test_8_post(unsigned long nthreads, enum loop_mode loop,
+                 enum boundary_type btype, unsigned long long bound)
+{
+    picotm_unregister_lock_range(&core_test_8_lock);
+    picotm_rwlock_uninit(&core_test_8_lock);
+
+    picotm_set_conflict_profiling(false);
+}
+
+static void
+core_test_8(unsigned int tid)
+{
+    picotm_begin
+
+        if (!picotm_number_of_restarts()) {
+            picotm_resolve_conflict(&core_test_8_lock);
+        }
+
+    picotm_commit
+    picotm_end
+
+    struct picotm_conflict_hotspot hotspot[16];
+    size_t nhotspots = picotm_get_conflict_hotspots(hotspot,
+                                                    arraylen(hotspot));
+
+    for (size_t i = 0; i < nhotspots; ++i) {
+        if (hotspot[i].lock != &core_test_8_lock) {
+            continue;
+        }
+        if (!hotspot[i].nconflicts) {
+            tap_error("Conflict has not been counted.\n");
+            abort_safe_block();
+        }
+        if (strcmp(hotspot[i].description, "core test 8")) {
+            tap_error("Lock has wrong description.\n");
+            abort_safe_block();
+        }
+        return;
+    }
+
+    tap_error("Conflicting lock has not been profiled.\n");
+    abort_safe_block();
+}
+
+/* Tests 9 to 11
+ *
+ * Each transaction write-locks a thread-local R/W lock and then tries
+ * to read-lock it. The second attempt always conflicts. The contention-
+ * management policy decides if the transaction waits for the lock
+ * before it signals the conflict. With the tested policies, a waiting
+ * transaction parks for at least 100 us. A transaction that doesn't
+ * wait returns well before.
+ */
+
+static const unsigned long long CORE_TEST_WAIT_NS = 100000;
+
+/* The number of transactions that test for a conflict without waiting.
+ * Only the fastest one counts, so preemption doesn't fail the test. */
+static const unsigned long CORE_TEST_NTXS = 16;
+
+static __thread bool          t_core_test_is_registered;
+static __thread unsigned long t_core_test_module;
+
+static void
+core_test_release_cb(void* data)
+{
+    t_core_test_is_registered = false;
+}
+
+static unsigned long
+core_test_get_module(void)
+{
+    static const struct picotm_module_ops s_ops = {
+        .release = core_test_release_cb
+    };
+
+    if (t_core_test_is_registered) {
+        return t_core_test_module;
+    }
+
+    struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+
+    t_core_test_module = picotm_register_module(&s_ops, nullptr, &error);
+    if (picotm_error_is_set(&error)) {
+        tap_error("picotm_register_module() failed.\n");
+        abort_safe_block();
+    }
+    t_core_test_is_registered = true;
+
+    return t_core_test_module;
+}
+
+static unsigned long long
+core_test_get_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Returns the time the transaction spent on the lock conflict in
+ * nanoseconds. Before the conflict, the transaction appends 'nevents'
+ * no-op events and sleeps for 'delay'. */
+static unsigned long long
+core_test_conflict(struct picotm_rwlock* lock, unsigned long nevents,
+                   const struct timespec* delay)
+{
+    unsigned long module = core_test_get_module();
+
+    picotm_safe unsigned long long ns = 0;
+    picotm_safe bool is_conflicting = false;
+
+    picotm_begin
+
+        for (unsigned long i = 0; i < nevents; ++i) {
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_append_event(module, 0, 0, &error);
+            if (picotm_error_is_set(&error)) {
+                picotm_recover_from_error(&error);
+            }
+        }
+
+        if (delay) {
+            nanosleep(delay, nullptr);
+        }
+
+        struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+        picotm_rwlock_try_wrlock(lock, false, &error);
+        if (picotm_error_is_set(&error)) {
+            picotm_recover_from_error(&error);
+        }
+
+        unsigned long long beg = core_test_get_ns();
+        picotm_rwlock_try_rdlock(lock, &error);
+        ns = core_test_get_ns() - beg;
+
+        is_conflicting = picotm_error_is_conflicting(&error);
+
+        picotm_rwlock_unlock(lock);
+
+    picotm_commit
+    picotm_end
+
+    if (!is_conflicting) {
+        tap_error("Lock conflict has not been signalled.\n");
+        abort_safe_block();
+    }
+
+    return ns;
+}
+
+/* Tests that transactions signal the conflict without waiting. */
+static void
+core_test_no_wait(struct picotm_rwlock* lock, unsigned long nevents)
+{
+    unsigned long long min_ns = ~0ull;
+
+    for (unsigned long i = 0; i < CORE_TEST_NTXS; ++i) {
+        unsigned long long ns = core_test_conflict(lock, nevents, nullptr);
+        if (ns < min_ns) {
+            min_ns = ns;
+        }
+    }
+
+    if (min_ns >= CORE_TEST_WAIT_NS) {
+        tap_error("Transaction waited for conflicting lock.\n");
+        abort_safe_block();
+    }
+}
+
+/* Tests that a transaction waits before signalling the conflict. */
+static void
+core_test_wait(struct picotm_rwlock* lock, unsigned long nevents,
+               const struct timespec* delay)
+{
+    unsigned long long ns = core_test_conflict(lock, nevents, delay);
+
+    if (ns < CORE_TEST_WAIT_NS) {
+        tap_error("Transaction did not wait for conflicting lock.\n");
+        abort_safe_block();
+    }
+}
+
+static void
+core_test_post_restore_policy(unsigned long nthreads, enum loop_mode loop,
+                              enum boundary_type btype,
+                              unsigned long long bound)
+{
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_GREEDY);
+}
+
+/* Test 9
+ */
+
+static const char core_test_9_desc[] =
+    "Test that the passive policy signals conflicts without waiting.";
+
+static void
+core_test_9_pre(unsigned long nthreads, enum loop_mode loop,
+                enum boundary_type btype, unsigned long long bound)
+{
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_PASSIVE);
+}
+
+static void
+core_test_9(unsigned int tid)
+{
+    struct picotm_rwlock lock;
+    picotm_rwlock_init(&lock);
+
+    /* Not even transactions with plenty of karma wait. */
+    core_test_no_wait(&lock, 0);
+    core_test_no_wait(&lock, 128);
+
+    picotm_rwlock_uninit(&lock);
+}
+
+/* Test 10
+ */
+
+static const char core_test_10_desc[] =
+    "Test that the greedy policy only lets old transactions wait.";
+
+static void
+core_test_10_pre(unsigned long nthreads, enum loop_mode loop,
+                 enum boundary_type btype, unsigned long long bound)
+{
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_GREEDY);
+}
+
+static void
+core_test_10(unsigned int tid)
+{
+    /* Transaction age comes from the coarse clock. Sleeping for a few
+     * of its ticks makes the transaction old enough to wait. */
+    static const struct timespec delay = {0, 20000000};
+
+    struct picotm_rwlock lock;
+    picotm_rwlock_init(&lock);
+
+    core_test_no_wait(&lock, 0);
+    core_test_wait(&lock, 0, &delay);
+
+    picotm_rwlock_uninit(&lock);
+}
+
+/* Test 11
+ */
+
+static const char core_test_11_desc[] =
+    "Test that the karma policy only lets transactions with karma wait.";
+
+static void
+core_test_11_pre(unsigned long nthreads, enum loop_mode loop,
+                 enum boundary_type btype, unsigned long long bound)
+{
+    picotm_set_contention_policy(PICOTM_CONTENTION_POLICY_KARMA);
+}
+
+static void
+core_test_11(unsigned int tid)
+{
+    struct picotm_rwlock lock;
+    picotm_rwlock_init(&lock);
+
+    core_test_no_wait(&lock, 0);
+    core_test_wait(&lock, 128, nullptr);
+
+    picotm_rwlock_uninit(&lock);
+}
+
+/* Test 12
+ */
+
+static const char core_test_12_desc[] =
+    "Test a module that registers during a transaction.";
+
+static __thread bool          t_core_test_12_is_registered;
+static __thread unsigned long t_core_test_12_nbegins;
+static __thread unsigned long t_core_test_12_nfinishs;
+
+static void
+core_test_12_begin_cb(void* data, struct picotm_error* error)
+{
+    ++t_core_test_12_nbegins;
+}
+
+static void
+core_test_12_finish_cb(void* data, struct picotm_error* error)
+{
+    ++t_core_test_12_nfinishs;
+}
+
+static void
+core_test_12_release_cb(void* data)
+{
+    t_core_test_12_is_registered = false;
+}
+
+/* Runs a transaction and tests that the module began and finished. */
+static void
+core_test_12_tx(void)
+{
+    static const struct picotm_module_ops s_ops = {
+        .begin = core_test_12_begin_cb,
+        .finish = core_test_12_finish_cb,
+        .release = core_test_12_release_cb
+    };
+
+    t_core_test_12_nbegins = 0;
+    t_core_test_12_nfinishs = 0;
+
+    picotm_begin
+
+        /* The first transaction of each thread registers the module
+         * after it began. Later transactions begin the module with all
+         * other modules. */
+        if (!t_core_test_12_is_registered) {
+            struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+            picotm_register_module(&s_ops, nullptr, &error);
+            if (picotm_error_is_set(&error)) {
+                picotm_recover_from_error(&error);
+            }
+            t_core_test_12_is_registered = true;
+        }
+
+    picotm_commit
+    picotm_end
+
+    if (t_core_test_12_nbegins != 1) {
+        tap_error("Module has not begun.\n");
+        abort_safe_block();
+    }
+    if (t_core_test_12_nfinishs != 1) {
+        tap_error("Module has not finished.\n");
+        abort_safe_block();
+    }
+}
+
+static void
+core_test_12(unsigned int tid)
+{
+    core_test_12_tx();
+}
+
+/* Test 13
+ */
+
+static const char core_test_13_desc[] =
+    "Test a transaction after a non-recoverable error.";
+
+static void
+core_test_13(unsigned int tid)
+{
+    picotm_safe bool performed_error_recovery = false;
+
+    picotm_begin
+
+        struct picotm_error error = PICOTM_ERROR_INITIALIZER;
+        picotm_error_set_error_code(&error, PICOTM_GENERAL_ERROR);
+        picotm_error_mark_as_non_recoverable(&error);
+        picotm_recover_from_error(&error);
+
+    picotm_commit
+
+        performed_error_recovery = true;
+
+    picotm_end
+
+    if (!performed_error_recovery) {
+        tap_error("Transaction did not perform error recovery.\n");
+        abort_safe_block();
+    }
+
+    /* The next transaction starts from a clean state. It's not
+     * nested into the failed transaction and commits. */
+    core_test_12_tx();
+}
+
 static const struct test_func core_test[] = {
     {core_test_1_desc, core_test_1, nullptr, nullptr},
     {core_test_2_desc, core_test_2, nullptr, nullptr},
     {core_test_3_desc, core_test_3, nullptr, nullptr},
-    {core_test_4_desc, core_test_4, nullptr, nullptr}
+    {core_test_4_desc, core_test_4, nullptr, nullptr},
+    {core_test_5_desc, core_test_5, nullptr, nullptr},
+    {core_test_6_desc, core_test_6, nullptr, nullptr},
+    {core_test_7_desc, core_test_7, nullptr, nullptr},
+    {core_test_8_desc, core_test_8, core_test_8_pre, core_test_8_post},
+    {core_test_9_desc, core_test_9, core_test_9_pre,
+     core_test_post_restore_policy},
+    {core_test_10_desc, core_test_10, core_test_10_pre,
+     core_test_post_restore_policy},
+    {core_test_11_desc, core_test_11, core_test_11_pre,
+     core_test_post_restore_policy},
+    {core_test_12_desc, core_test_12, nullptr, nullptr},
+    {core_test_13_desc, core_test_13, nullptr, nullptr}
 };
 
 /*
@@ -0,0 +1,126 @@
+#!/usr/bin/env perl
+#
+# picotm - A system-level transaction manager
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+
+# Converts a picotm trace file to the Chrome trace format. Load the
+# output in chrome://tracing or https://ui.perfetto.dev.
+#
+# Usage: picotm-trace2json.pl <trace file> [<json file>]
+
+# Perl language settings
+use v5.22;
+use autodie;
+use strict;
+use warnings;
+
+# The trace-file format, see src/picotm_trace.h.
+my $magic = 'PICOTMTR';
+my $version = 1;
+my $record_size = 24;
+
+my @event_name = (
+    'TX_BEGIN',
+    'TX_COMMIT',
+    'TX_ROLLBACK',
+    'LOCK_ACQUIRE',
+    'LOCK_BLOCKED',
+    'LOCK_CONFLICT',
+    'WAIT_BEGIN',
+    'WAIT_END',
+    'WAKE_UP'
+);
+
+my @tx_mode = ('revocable', 'irrevocable', 'prioritized');
+
+die "Usage: $0 <trace file> [<json file>]\n" unless @ARGV >= 1;
+
+open(my $in, '<:raw', $ARGV[0]);
+
+my $out = \*STDOUT;
+if (@ARGV > 1) {
+    open($out, '>', $ARGV[1]);
+}
+
+my $header;
+read($in, $header, 16) == 16 or die "$ARGV[0]: truncated header\n";
+
+my ($file_magic, $file_version, $file_record_size) = unpack('a8 L< L<',
+                                                            $header);
+die "$ARGV[0]: not a picotm trace file\n" unless $file_magic eq $magic;
+die "$ARGV[0]: unsupported version $file_version\n"
+    unless $file_version == $version;
+die "$ARGV[0]: unsupported record size $file_record_size\n"
+    unless $file_record_size == $record_size;
+
+my @record;
+my $buf;
+while (read($in, $buf, $record_size) == $record_size) {
+    my ($ns, $arg, $tid, $event) = unpack('Q< Q< L< S<', $buf);
+    push(@record, [$ns, $arg, $tid, $event]);
+}
+
+close($in);
+
+# Chrome requires begin and end events of a thread in order.
+@record = sort { $a->[0] <=> $b->[0] } @record;
+
+my $ns_base = @record ? $record[0][0] : 0;
+
+sub event {
+    my ($ph, $name, $ns, $tid, $args) = @_;
+    my $ts = sprintf('%.3f', ($ns - $ns_base) / 1000);
+    my $json = sprintf('{"name":"%s","cat":"picotm","ph":"%s",' .
+                       '"ts":%s,"pid":0,"tid":%u',
+                       $name, $ph, $ts, $tid);
+    $json .= ',"s":"t"' if $ph eq 'i';
+    $json .= sprintf(',"args":{%s}', $args) if defined $args;
+    return $json . '}';
+}
+
+my @json;
+foreach my $r (@record) {
+    my ($ns, $arg, $tid, $event) = @$r;
+    my $name = $event_name[$event] // "EVENT_$event";
+
+    if ($name eq 'TX_BEGIN') {
+        my $mode = $tx_mode[$arg] // $arg;
+        push(@json, event('B', 'tx', $ns, $tid, "\"mode\":\"$mode\""));
+    } elsif ($name eq 'TX_COMMIT') {
+        push(@json, event('E', 'tx', $ns, $tid,
+                          "\"result\":\"commit\",\"nretries\":$arg"));
+    } elsif ($name eq 'TX_ROLLBACK') {
+        push(@json, event('E', 'tx', $ns, $tid,
+                          "\"result\":\"rollback\",\"nretries\":$arg"));
+    } elsif ($name eq 'WAIT_BEGIN') {
+        push(@json, event('B', 'wait', $ns, $tid, "\"lock_owner\":$arg"));
+    } elsif ($name eq 'WAIT_END') {
+        my $woken_up = $arg ? 'true' : 'false';
+        push(@json, event('E', 'wait', $ns, $tid,
+                          "\"woken_up\":$woken_up"));
+    } elsif ($name eq 'WAKE_UP') {
+        push(@json, event('i', 'wake-up', $ns, $tid, "\"lock_owner\":$arg"));
+    } else {
+        my $lock = sprintf('"lock":"0x%x"', $arg);
+        push(@json, event('i', lc($name =~ s/_/-/gr), $ns, $tid, $lock));
+    }
+}
+
+print $out "{\"traceEvents\":[\n";
+print $out join(",\n", @json);
+print $out "\n],\"displayTimeUnit\":\"ns\"}\n";